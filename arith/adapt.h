@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2017, Max von Buelow
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+/*
+ * Adaptation policies for the statistics modules: how much a coded symbol counts and how quickly old symbols are forgotten.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "stat_pow2.h"
+
+namespace arith {
+
+// Every coded symbol adds INC to its frequency, and all frequencies are halved as soon as their sum exceeds 2^LIMIT_BITS.
+// Halving forgets the past exponentially: a symbol coded k halvings ago weighs 2^-k. A larger INC moves away from the initial uniform counts sooner, a smaller limit forgets sooner.
+// The statistics module still halves at its own limit (FFULL), if that is lower.
+template <int INC = 1, int LIMIT_BITS = 62>
+struct Adaptation {
+	static const int inc = INC;
+	static const int limit_bits = LIMIT_BITS;
+};
+
+// Sum of the adaptive counts of a statistics module, which the policy compares with its limit
+template <typename S>
+static inline typename S::FreqType count_total(const S &s)
+{
+	return s.total();
+}
+template <typename TF, typename TS, typename TC, int BITS>
+static inline TF count_total(const Pow2StatisticsModule<TF, TS, TC, BITS> &s)
+{
+	return s.sum; // the total is constant
+}
+
+// Statistics module S adapting by policy A; init() keeps the increment of S, so that all symbols start with the same small counts
+template <typename S, typename A>
+struct Adapted : S {
+	typedef typename S::FreqType TF;
+	typedef typename S::SymType TS;
+	typedef typename S::CountType TC;
+
+	static const uint64_t LIMIT = uint64_t(1) << A::limit_bits;
+
+	Adapted(TC _n = 256) : S(_n)
+	{}
+
+	void inc(TS s, TF incr = 1)
+	{
+		S::inc(s, incr * A::inc);
+		if (count_total(static_cast<const S&>(*this)) > LIMIT) S::halve();
+	}
+};
+
+template <typename S, typename A>
+static inline typename S::FreqType count_total(const Adapted<S, A> &s)
+{
+	return count_total(static_cast<const S&>(s));
+}
+
+}
@@ -8,35 +8,133 @@
 
 #pragma once
 
+#include <stdint.h>
+#include <cstddef>
 #include <istream>
 #include <ostream>
+#include <vector>
 
 namespace arith {
 
+static const std::size_t STREAM_BUF_SIZE = 1 << 16;
+
+// Block-buffered byte source, reading either from a std::istream or directly from memory
+struct byteistream {
+	std::istream *is;
+	std::vector<unsigned char> buf;
+	const unsigned char *cur, *end;
+
+	byteistream(std::istream &_is) : is(&_is), buf(STREAM_BUF_SIZE), cur(NULL), end(NULL)
+	{}
+	byteistream(const unsigned char *data, std::size_t size) : is(NULL), cur(data), end(data + size)
+	{}
+
+	byteistream(const byteistream&) = delete;
+	byteistream &operator=(const byteistream&) = delete;
+
+	std::size_t available() const
+	{
+		return end - cur;
+	}
+
+	unsigned char get()
+	{
+		if (cur == end && !refill()) return 0xFF; // reading beyond the end behaves like std::istream::get() returning EOF
+		return *cur++;
+	}
+
+private:
+	bool refill()
+	{
+		if (is == NULL) return false;
+		is->read((char*)buf.data(), buf.size());
+		cur = buf.data();
+		end = cur + is->gcount();
+		return cur != end;
+	}
+};
+
+// Block-buffered byte sink, writing either to a std::ostream or appending to a vector in memory
+struct byteostream {
+	std::ostream *os;
+	std::vector<unsigned char> *vec;
+	std::vector<unsigned char> buf;
+	std::size_t n;
+
+	byteostream(std::ostream &_os) : os(&_os), vec(NULL), buf(STREAM_BUF_SIZE), n(0)
+	{}
+	byteostream(std::vector<unsigned char> &_vec) : os(NULL), vec(&_vec), buf(STREAM_BUF_SIZE), n(0)
+	{}
+
+	~byteostream()
+	{
+		flush();
+	}
+
+	byteostream(const byteostream&) = delete;
+	byteostream &operator=(const byteostream&) = delete;
+
+	void put(unsigned char c)
+	{
+		if (n == buf.size()) flush();
+		buf[n++] = c;
+	}
+
+	void flush()
+	{
+		if (n == 0) return;
+		if (os != NULL) os->write((const char*)buf.data(), n);
+		else vec->insert(vec->end(), buf.begin(), buf.begin() + n);
+		n = 0;
+	}
+};
+
 struct bitistream {
-	std::istream &is;
-	int idx;
-	unsigned char buf;
+	byteistream is;
+	uint64_t word;
+	int avail;
 
-	bitistream(std::istream &_is) : is(_is), idx(8), buf(0)
+	bitistream(std::istream &_is) : is(_is), word(0), avail(0)
+	{}
+	bitistream(const unsigned char *data, std::size_t size) : is(data, size), word(0), avail(0)
 	{}
 
 	bitistream &operator>>(unsigned char &bit)
 	{
-		if (idx == 8) {
-			buf = is.get();
-			idx = 0;
-		}
-		bit = (buf >> (7 - idx++)) & 1;
+		if (avail == 0) refill();
+		bit = word >> 63;
+		word <<= 1;
+		--avail;
 		return *this;
 	}
+
+private:
+	void refill()
+	{
+		// extract a whole word at once if possible
+		if (is.available() >= 8) {
+			const unsigned char *p = is.cur;
+			word = 0;
+			for (int i = 0; i < 8; ++i) {
+				word = (word << 8) | p[i];
+			}
+			is.cur += 8;
+		} else {
+			for (int i = 0; i < 8; ++i) {
+				word = (word << 8) | is.get();
+			}
+		}
+		avail = 64;
+	}
 };
 struct bitostream {
-	std::ostream &os;
+	byteostream os;
+	uint64_t word;
 	int idx;
-	unsigned char buf;
 
-	bitostream(std::ostream &_os) : os(_os), idx(0), buf(0)
+	bitostream(std::ostream &_os) : os(_os), word(0), idx(0)
+	{}
+	bitostream(std::vector<unsigned char> &_vec) : os(_vec), word(0), idx(0)
 	{}
 
 	~bitostream()
@@ -46,16 +144,22 @@ struct bitostream {
 
 	void flush()
 	{
-		if (idx == 0) return; // buffer already empty
-		os << buf;
-		buf = 0; idx = 0; // clear and reset
+		// write the remaining bits padded with zeros to full bytes
+		for (int i = 0; i < idx; i += 8) {
+			os.put(word >> (56 - i));
+		}
+		word = 0; idx = 0; // clear and reset
+		os.flush();
 	}
 
 	bitostream &operator<<(unsigned char bit)
 	{
-		buf |= bit << (7 - idx);
-		if (++idx == 8) {
-			flush();
+		word |= uint64_t(bit) << (63 - idx);
+		if (++idx == 64) {
+			for (int i = 0; i < 64; i += 8) {
+				os.put(word >> (56 - i));
+			}
+			word = 0; idx = 0;
 		}
 		return *this;
 	}
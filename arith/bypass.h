@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2017, Max von Buelow
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+namespace arith {
+
+// log2(x) with 4 fractional bits (x > 0), from the leading one and the 4 bits below it
+static inline uint32_t log2_fix4(uint64_t x)
+{
+	static const uint8_t FRAC[16] = { 0, 1, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 15 };
+	int e = 63 - __builtin_clzll(x);
+	uint32_t m = e >= 4 ? (x >> (e - 4)) & 15 : (x << (4 - e)) & 15;
+	return e * 16 + FRAC[m];
+}
+
+// Decides whether the symbols of a byte stream are coded with their statistics module or bypassed as 8 raw bits, which skips the search and the update of the statistics.
+// The cost of the modeled symbols is estimated from their frequencies; after a window of 2^WINDOW_BITS symbols costing at least 7.875 bits on average the stream is bypassed for BYPASS windows.
+// The following window is modeled again (with the statistics left as they were) to check whether the stream has become compressible.
+// Encoder and decoder take the same decisions, so nothing has to be signaled.
+template <int WINDOW_BITS = 9, int BYPASS = 8>
+struct BypassSwitch {
+	static const uint32_t WINDOW = uint32_t(1) << WINDOW_BITS;
+	static const uint32_t LIMIT = uint32_t(8 * 16 - 2) << WINDOW_BITS;
+
+	uint32_t n, cost; // symbols and their cost (in 1/16 bits) in the current window
+	int off; // remaining bypassed windows
+
+	BypassSwitch() : n(0), cost(0), off(0)
+	{}
+
+	bool bypassed() const
+	{
+		return off > 0;
+	}
+	// after a modeled symbol with frequency f of the total t
+	void coded(uint64_t f, uint64_t t)
+	{
+		cost += log2_fix4(t) - log2_fix4(f);
+		if (++n == WINDOW) {
+			if (cost >= LIMIT) off = BYPASS;
+			n = 0;
+			cost = 0;
+		}
+	}
+	// after a bypassed symbol
+	void skipped()
+	{
+		if (++n == WINDOW) {
+			n = 0;
+			--off;
+		}
+	}
+};
+
+// Never bypasses, e.g. for passes that have to see every symbol
+struct NoBypass {
+	bool bypassed() const
+	{
+		return false;
+	}
+	void coded(uint64_t f, uint64_t t)
+	{}
+	void skipped()
+	{}
+};
+
+}
@@ -19,8 +19,10 @@
 #include <algorithm>
 #include <istream>
 #include <ostream>
+#include <vector>
 
 #include "bitstream.h"
+#include "traits.h"
 
 namespace arith {
 
@@ -44,7 +46,9 @@ struct Encoder : Coder<TF> {
 	bitostream os;
 	bool flushed;
 
-	Encoder(std::ostream &_os) : os(_os), L(0), R(HALF), bits_outstanding(0), flushed(false)
+	Encoder(std::ostream &_os) : L(0), R(HALF), bits_outstanding(0), os(_os), flushed(false)
+	{}
+	Encoder(std::vector<unsigned char> &_out) : L(0), R(HALF), bits_outstanding(0), os(_out), flushed(false)
 	{}
 
 	~Encoder()
@@ -68,7 +72,33 @@ struct Encoder : Coder<TF> {
 
 	void operator()(TF l, TF h, TF t)
 	{
-		TF r = R / t;
+		update(R / t, l, h, t);
+	}
+	void pow2(TF l, TF h, int bits) // same as operator() with t = 2^bits
+	{
+		update(R >> bits, l, h, TF(1) << bits);
+	}
+	void bypass(TF v, int bits) // codes the lowest bits of v (at most 16) with equal probabilities
+	{
+		pow2(v, v + 1, bits);
+	}
+	void bit(int v, TF p0, int bits) // codes a binary decision, p0 / 2^bits is the probability of 0
+	{
+		if (v) pow2(p0, TF(1) << bits, bits);
+		else pow2(0, p0, bits);
+	}
+	template <typename S>
+	void operator()(S &freq, typename S::SymType s)
+	{
+		TF l, h;
+		freq.range(s, l, h);
+		if (total_bits<S>::value) pow2(l, h, total_bits<S>::value);
+		else (*this)(l, h, freq.total());
+	}
+
+private:
+	void update(TF r, TF l, TF h, TF t)
+	{
 		L = L + r * l;
 		if (h < t)
 			R = r * (h - l);
@@ -89,15 +119,6 @@ struct Encoder : Coder<TF> {
 			R *= 2;
 		}
 	}
-	template <typename S>
-	void operator()(S &freq, typename S::SymType s)
-	{
-		TF l, h, t = freq.total();
-		freq.range(s, l, h);
-		(*this)(l, h, t);
-	}
-
-private:
 	void write_one_bit(unsigned char bit)
 	{
 		os << bit;
@@ -121,11 +142,13 @@ struct Decoder : Coder<TF> {
 	TF R, D, r; // R = range
 	bitistream is;
 
-	Decoder(std::istream &_is) : is(_is), R(HALF), D(0)
+	Decoder(std::istream &_is) : R(HALF), D(0), is(_is)
 	{
-		for (int i = 0; i < b; ++i) {
-			D = 2 * D + read_one_bit();
-		}
+		init();
+	}
+	Decoder(const unsigned char *data, std::size_t size) : R(HALF), D(0), is(data, size)
+	{
+		init();
 	}
 
 	Decoder(const Decoder&) = delete;
@@ -136,6 +159,11 @@ struct Decoder : Coder<TF> {
 		r = R / t;
 		return std::min(t - 1, D / r);
 	}
+	TF decode_target_pow2(int bits) // same as decode_target with t = 2^bits
+	{
+		r = R >> bits;
+		return std::min((TF(1) << bits) - 1, D / r);
+	}
 
 	void operator()(TF l, TF h, TF t)
 	{
@@ -151,10 +179,36 @@ struct Decoder : Coder<TF> {
 			D = 2 * D + read_one_bit();
 		}
 	}
+	void pow2(TF l, TF h, int bits)
+	{
+		(*this)(l, h, TF(1) << bits);
+	}
+	TF bypass(int bits)
+	{
+		TF v = decode_target_pow2(bits);
+		pow2(v, v + 1, bits);
+		return v;
+	}
+	int bit(TF p0, int bits)
+	{
+		// the target is >= p0 iff D >= r * p0: no division needed
+		r = R >> bits;
+		int v = D >= r * p0;
+		if (v) pow2(p0, TF(1) << bits, bits);
+		else pow2(0, p0, bits);
+		return v;
+	}
 	template <typename S>
 	typename S::SymType operator()(S &freq)
 	{
-		TF l, h, t = freq.total();
+		TF l, h;
+		if (total_bits<S>::value) {
+			TF target = decode_target_pow2(total_bits<S>::value);
+			typename S::SymType s = freq.symbol(target, l, h);
+			pow2(l, h, total_bits<S>::value);
+			return s;
+		}
+		TF t = freq.total();
 		TF target = decode_target(t);
 		typename S::SymType s = freq.symbol(target, l, h);
 		(*this)(l, h, t);
@@ -163,6 +217,12 @@ struct Decoder : Coder<TF> {
 
 
 private:
+	void init()
+	{
+		for (int i = 0; i < b; ++i) {
+			D = 2 * D + read_one_bit();
+		}
+	}
 	unsigned char read_one_bit()
 	{
 		unsigned char bit;
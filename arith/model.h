@@ -12,18 +12,21 @@
 
 namespace arith {
 
-template <typename TF = uint64_t>
+template <typename E = Encoder<>, typename D = Decoder<>>
 struct Model {
-	virtual void enc(Encoder<TF> &coder, const unsigned char *s, int n) = 0;
-	virtual void dec(Decoder<TF> &coder, unsigned char *s, int n) = 0;
+	typedef E EncoderType;
+	typedef D DecoderType;
+
+	virtual void enc(E &coder, const unsigned char *s, int n) = 0;
+	virtual void dec(D &coder, unsigned char *s, int n) = 0;
 
 	template <typename T>
-	void encode(Encoder<TF> &coder, const T &s)
+	void encode(E &coder, const T &s)
 	{
 		enc(coder, (const unsigned char*)&s, sizeof(T));
 	}
 	template <typename T>
-	T decode(Decoder<TF> &coder)
+	T decode(D &coder)
 	{
 		T s;
 		dec(coder, (unsigned char*)&s, sizeof(T));
@@ -31,8 +34,8 @@ struct Model {
 	}
 };
 
-template <typename T, typename S, typename TF = uint64_t>
-struct ModelMult : Model<TF> {
+template <typename T, typename S, typename E = Encoder<>, typename D = Decoder<>>
+struct ModelMult : Model<E, D> {
 	S stats[sizeof(T)];
 
 	ModelMult(bool init = true)
@@ -54,7 +57,7 @@ struct ModelMult : Model<TF> {
 		}
 	}
 
-	void enc(Encoder<TF> &coder, const unsigned char *s, int n)
+	void enc(E &coder, const unsigned char *s, int n)
 	{
 #ifdef HAVE_ASSERT
 		assert_eq(sizeof(T), n);
@@ -65,7 +68,7 @@ struct ModelMult : Model<TF> {
 		}
 	}
 
-	void dec(Decoder<TF> &coder, unsigned char *s, int n)
+	void dec(D &coder, unsigned char *s, int n)
 	{
 #ifdef HAVE_ASSERT
 		assert_eq(sizeof(T), n);
@@ -77,4 +80,55 @@ struct ModelMult : Model<TF> {
 	}
 };
 
+// Codes unsigned integers as their bit length (adaptively, with BITS + 1 symbols) followed by the bits below the leading one (bypass coded).
+// Small values cost a single adaptive symbol instead of one per byte.
+template <typename T, typename S, typename E = Encoder<>, typename D = Decoder<>>
+struct ModelInt : Model<E, D> {
+	static const int BITS = sizeof(T) * 8;
+
+	S stat;
+
+	ModelInt() : stat(BITS + 1)
+	{
+		for (int i = 0; i <= BITS; ++i) {
+			stat.init(i);
+		}
+	}
+
+	void enc(E &coder, const unsigned char *s, int n)
+	{
+#ifdef HAVE_ASSERT
+		assert_eq(sizeof(T), n);
+#endif
+		T v = *(const T*)s;
+		int len = v == 0 ? 0 : 64 - __builtin_clzll(v);
+		coder(stat, len);
+		stat.inc(len);
+
+		// the leading one is implied by the length
+		for (int rem = len - 1; rem > 0;) {
+			int k = rem < 16 ? rem : 16;
+			rem -= k;
+			coder.bypass((v >> rem) & ((T(1) << k) - 1), k);
+		}
+	}
+
+	void dec(D &coder, unsigned char *s, int n)
+	{
+#ifdef HAVE_ASSERT
+		assert_eq(sizeof(T), n);
+#endif
+		int len = coder(stat);
+		stat.inc(len);
+
+		T v = len == 0 ? 0 : 1;
+		for (int rem = len - 1; rem > 0;) {
+			int k = rem < 16 ? rem : 16;
+			rem -= k;
+			v = (v << k) | coder.bypass(k);
+		}
+		*(T*)s = v;
+	}
+};
+
 }
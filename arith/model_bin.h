@@ -0,0 +1,167 @@
+/*
+ * Copyright (C) 2017, Max von Buelow
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+/*
+ * Binarized models: values are decomposed into binary decisions, each coded with its own adaptive probability.
+ *
+ * Related publications:
+ * Marpe, Detlev, Heiko Schwarz, and Thomas Wiegand. "Context-based adaptive binary arithmetic coding in the H.264/AVC video compression standard." IEEE Transactions on Circuits and Systems for Video Technology 13.7 (2003): 620-636.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+namespace arith {
+
+// Adaptive probability of a binary decision: p0 / 2^BITS is the probability of 0 and moves by 1/2^SHIFT of the distance towards the coded bit, no counts and no halving
+template <int BITS = 12, int SHIFT = 5>
+struct BitModel {
+	static const uint32_t ONE = uint32_t(1) << BITS;
+
+	uint16_t p0;
+
+	BitModel() : p0(ONE / 2)
+	{}
+
+	template <typename E>
+	void enc(E &coder, int v)
+	{
+		coder.bit(v, p0, BITS);
+		update(v);
+	}
+	template <typename D>
+	int dec(D &coder)
+	{
+		int v = coder.bit(p0, BITS);
+		update(v);
+		return v;
+	}
+
+private:
+	void update(int v)
+	{
+		// p0 never reaches 0 or ONE, since the steps vanish before
+		if (v) p0 -= p0 >> SHIFT;
+		else p0 += (ONE - p0) >> SHIFT;
+	}
+};
+
+// Two-speed estimator: the probability of 0 is the mean of a fast (1/2^FAST) and a slow (1/2^SLOW) adapting probability.
+// The fast one follows local changes of the statistics, the slow one keeps the precision on stationary data.
+template <int BITS = 12, int FAST = 4, int SLOW = 7>
+struct MixBitModel {
+	static const uint32_t ONE = uint32_t(1) << BITS;
+
+	uint16_t pf, ps;
+
+	MixBitModel() : pf(ONE / 2), ps(ONE / 2)
+	{}
+
+	template <typename E>
+	void enc(E &coder, int v)
+	{
+		coder.bit(v, p0(), BITS);
+		update(v);
+	}
+	template <typename D>
+	int dec(D &coder)
+	{
+		int v = coder.bit(p0(), BITS);
+		update(v);
+		return v;
+	}
+
+private:
+	uint32_t p0() const
+	{
+		// both are within (0, ONE), and so is their mean
+		return (uint32_t(pf) + ps) >> 1;
+	}
+	void update(int v)
+	{
+		if (v) {
+			pf -= pf >> FAST;
+			ps -= ps >> SLOW;
+		} else {
+			pf += (ONE - pf) >> FAST;
+			ps += (ONE - ps) >> SLOW;
+		}
+	}
+};
+
+// Codes unsigned integers of up to nbits bits (at most 64) as binary decisions:
+// the bit length is binarized by a binary tree with one BitModel per node, the MBITS bits below the leading one by a tree per length, and the remaining bits are bypass coded.
+// Small values, like prediction residuals, cost only few decisions of the length tree, which adapt quickly. BM is the model of every decision.
+template <int MBITS = 2, typename BM = BitModel<>>
+struct BinaryInt {
+	static const int MAXLEN = 64;
+	static const int LBITS = 7; // enough for all lengths 0..MAXLEN
+
+	BM len[1 << LBITS];
+	BM mant[MAXLEN + 1][1 << MBITS];
+	int lbits; // depth of the length tree for nbits
+
+	BinaryInt(int nbits = MAXLEN) : lbits(0)
+	{
+		while ((1 << lbits) <= nbits) ++lbits;
+	}
+
+	template <typename E>
+	void enc(E &coder, uint64_t v)
+	{
+		int l = v == 0 ? 0 : 64 - __builtin_clzll(v);
+		int node = 1;
+		for (int i = lbits - 1; i >= 0; --i) {
+			int b = (l >> i) & 1;
+			len[node].enc(coder, b);
+			node = 2 * node + b;
+		}
+
+		// the leading one is implied by the length
+		int rem = l - 1;
+		node = 1;
+		for (int i = 0; i < MBITS && rem > 0; ++i) {
+			int b = (v >> --rem) & 1;
+			mant[l][node].enc(coder, b);
+			node = 2 * node + b;
+		}
+		while (rem > 0) {
+			int k = rem < 16 ? rem : 16;
+			rem -= k;
+			coder.bypass((v >> rem) & ((uint64_t(1) << k) - 1), k);
+		}
+	}
+	template <typename D>
+	uint64_t dec(D &coder)
+	{
+		int node = 1;
+		for (int i = 0; i < lbits; ++i) {
+			node = 2 * node + len[node].dec(coder);
+		}
+		int l = node - (1 << lbits);
+		if (l == 0) return 0;
+
+		uint64_t v = 1;
+		int rem = l - 1;
+		node = 1;
+		for (int i = 0; i < MBITS && rem > 0; ++i, --rem) {
+			int b = mant[l][node].dec(coder);
+			v = 2 * v + b;
+			node = 2 * node + b;
+		}
+		while (rem > 0) {
+			int k = rem < 16 ? rem : 16;
+			rem -= k;
+			v = (v << k) | coder.bypass(k);
+		}
+		return v;
+	}
+};
+
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2017, Max von Buelow
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <cmath>
+
+#include "traits.h"
+
+namespace arith {
+
+// Encoder with the interface of all other encoders that discards everything; it drives the models through a pass that only gathers statistics
+template <typename TF = uint64_t>
+struct NullEncoder {
+	typedef TF FreqType;
+
+	NullEncoder()
+	{}
+
+	NullEncoder(const NullEncoder&) = delete;
+	NullEncoder &operator=(const NullEncoder&) = delete;
+
+	void flush()
+	{}
+
+	void operator()(TF l, TF h, TF t)
+	{}
+	void pow2(TF l, TF h, int bits)
+	{}
+	void bypass(TF v, int bits)
+	{}
+	void bit(int v, TF p0, int bits)
+	{}
+	template <typename S>
+	void operator()(S &freq, typename S::SymType s)
+	{}
+};
+
+// Encoder that writes nothing but sums the bits an exact arithmetic coder would spend; used to compare encodings without coding them
+template <typename TF = uint64_t>
+struct CostEncoder {
+	typedef TF FreqType;
+	double bits;
+
+	CostEncoder() : bits(0)
+	{}
+
+	CostEncoder(const CostEncoder&) = delete;
+	CostEncoder &operator=(const CostEncoder&) = delete;
+
+	void flush()
+	{}
+
+	void operator()(TF l, TF h, TF t)
+	{
+		bits += std::log2(double(t) / double(h - l));
+	}
+	void pow2(TF l, TF h, int b)
+	{
+		bits += b - std::log2(double(h - l));
+	}
+	void bypass(TF v, int b)
+	{
+		bits += b;
+	}
+	void bit(int v, TF p0, int b)
+	{
+		if (v) pow2(p0, TF(1) << b, b);
+		else pow2(0, p0, b);
+	}
+	template <typename S>
+	void operator()(S &freq, typename S::SymType s)
+	{
+		TF l, h;
+		freq.range(s, l, h);
+		if (total_bits<S>::value) pow2(l, h, total_bits<S>::value);
+		else (*this)(l, h, freq.total());
+	}
+};
+
+}
@@ -0,0 +1,231 @@
+/*
+ * Copyright (C) 2017, Max von Buelow
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+/*
+ * Implementation of a byte-oriented Range Coder with carry propagation.
+ *
+ * Related publications:
+ * Martin, G. Nigel N. "Range encoding: an algorithm for removing redundancy from a digitised message." Video and Data Recording Conference, Southampton. 1979.
+ * Schindler, Michael. "A fast renormalisation for arithmetic coding." Proceedings DCC'98. IEEE, 1998.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <algorithm>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+#include "bitstream.h"
+#include "traits.h"
+
+namespace arith {
+
+template <typename TF = uint64_t>
+struct RangeCoder {
+	typedef TF FreqType;
+
+	static const int b = sizeof(TF) * 8;
+	static const TF TOP = TF(1) << (b - 8); // the range is renormalized as soon as it drops below TOP; totals must not exceed TOP
+};
+
+template <typename TF = uint64_t>
+struct RangeEncoder : RangeCoder<TF> {
+	using RangeCoder<TF>::b;
+	using RangeCoder<TF>::TOP;
+
+	TF L, R; // L = low, R = range
+	unsigned char carry, cache;
+	uint64_t cache_size; // number of bytes pending in the carry chain (cache followed by 0xFF bytes)
+	byteostream os;
+	bool flushed;
+
+	RangeEncoder(std::ostream &_os) : L(0), R(TF(-1)), carry(0), cache(0), cache_size(1), os(_os), flushed(false)
+	{}
+	RangeEncoder(std::vector<unsigned char> &_out) : L(0), R(TF(-1)), carry(0), cache(0), cache_size(1), os(_out), flushed(false)
+	{}
+
+	~RangeEncoder()
+	{
+		flush();
+	}
+
+	RangeEncoder(const RangeEncoder&) = delete;
+	RangeEncoder &operator=(const RangeEncoder&) = delete;
+
+	void flush()
+	{
+		if (flushed) return;
+		flushed = true;
+
+		for (int i = 0; i <= b / 8; ++i) {
+			shift_low();
+		}
+		os.flush();
+	}
+
+	void operator()(TF l, TF h, TF t)
+	{
+		update(R / t, l, h, t);
+	}
+	void pow2(TF l, TF h, int bits) // same as operator() with t = 2^bits
+	{
+		update(R >> bits, l, h, TF(1) << bits);
+	}
+	void bypass(TF v, int bits) // codes the lowest bits of v (at most 16) with equal probabilities
+	{
+		pow2(v, v + 1, bits);
+	}
+	void bit(int v, TF p0, int bits) // codes a binary decision, p0 / 2^bits is the probability of 0
+	{
+		if (v) pow2(p0, TF(1) << bits, bits);
+		else pow2(0, p0, bits);
+	}
+	template <typename S>
+	void operator()(S &freq, typename S::SymType s)
+	{
+		TF l, h;
+		freq.range(s, l, h);
+		if (total_bits<S>::value) pow2(l, h, total_bits<S>::value);
+		else (*this)(l, h, freq.total());
+	}
+
+private:
+	void update(TF r, TF l, TF h, TF t)
+	{
+		TF lo = r * l;
+		L += lo;
+		if (L < lo) carry = 1;
+		if (h < t)
+			R = r * (h - l);
+		else
+			R = R - lo;
+
+		while (R < TOP) {
+			R <<= 8;
+			shift_low();
+		}
+	}
+	void write_byte(unsigned char c)
+	{
+		os.put(c);
+	}
+	void shift_low()
+	{
+		// the top byte can only be emitted once it is certain that no carry will reach it anymore
+		if (L < (TF(0xFF) << (b - 8)) || carry) {
+			unsigned char c = cache;
+			do {
+				write_byte(c + carry);
+				c = 0xFF;
+			} while (--cache_size != 0);
+			cache = L >> (b - 8);
+			carry = 0;
+		}
+		++cache_size;
+		L <<= 8;
+	}
+};
+
+template <typename TF = uint64_t>
+struct RangeDecoder : RangeCoder<TF> {
+	using RangeCoder<TF>::b;
+	using RangeCoder<TF>::TOP;
+
+	TF R, D, r; // R = range, D = code - low
+	byteistream is;
+
+	RangeDecoder(std::istream &_is) : R(TF(-1)), D(0), is(_is)
+	{
+		init();
+	}
+	RangeDecoder(const unsigned char *data, std::size_t size) : R(TF(-1)), D(0), is(data, size)
+	{
+		init();
+	}
+
+	RangeDecoder(const RangeDecoder&) = delete;
+	RangeDecoder &operator=(const RangeDecoder&) = delete;
+
+	TF decode_target(TF t)
+	{
+		r = R / t;
+		return std::min(t - 1, D / r);
+	}
+	TF decode_target_pow2(int bits) // same as decode_target with t = 2^bits
+	{
+		r = R >> bits;
+		return std::min((TF(1) << bits) - 1, D / r);
+	}
+
+	void operator()(TF l, TF h, TF t)
+	{
+		// r already set by decode_target
+		D = D - r * l;
+		if (h < t)
+			R = r * (h - l);
+		else
+			R = R - r * l;
+
+		while (R < TOP) {
+			R <<= 8;
+			D = (D << 8) | read_byte();
+		}
+	}
+	void pow2(TF l, TF h, int bits)
+	{
+		(*this)(l, h, TF(1) << bits);
+	}
+	TF bypass(int bits)
+	{
+		TF v = decode_target_pow2(bits);
+		pow2(v, v + 1, bits);
+		return v;
+	}
+	int bit(TF p0, int bits)
+	{
+		// the target is >= p0 iff D >= r * p0: no division needed
+		r = R >> bits;
+		int v = D >= r * p0;
+		if (v) pow2(p0, TF(1) << bits, bits);
+		else pow2(0, p0, bits);
+		return v;
+	}
+	template <typename S>
+	typename S::SymType operator()(S &freq)
+	{
+		TF l, h;
+		if (total_bits<S>::value) {
+			TF target = decode_target_pow2(total_bits<S>::value);
+			typename S::SymType s = freq.symbol(target, l, h);
+			pow2(l, h, total_bits<S>::value);
+			return s;
+		}
+		TF t = freq.total();
+		TF target = decode_target(t);
+		typename S::SymType s = freq.symbol(target, l, h);
+		(*this)(l, h, t);
+		return s;
+	}
+
+private:
+	void init()
+	{
+		// the first byte is the (always empty) carry byte of the encoder
+		for (int i = 0; i <= b / 8; ++i) {
+			D = (D << 8) | read_byte();
+		}
+	}
+	unsigned char read_byte()
+	{
+		return is.get();
+	}
+};
+
+}
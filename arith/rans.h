@@ -0,0 +1,261 @@
+/*
+ * Copyright (C) 2017, Max von Buelow
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+/*
+ * Implementation of an interleaved range Asymmetric Numeral Systems (rANS) coder.
+ *
+ * Related publications:
+ * Duda, Jarek. "Asymmetric numeral systems: entropy coding combining speed of Huffman coding with compression rate of arithmetic coding." arXiv preprint arXiv:1311.2540 (2013).
+ * Giesen, Fabian. "Interleaved entropy coders." arXiv preprint arXiv:1402.3392 (2014).
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+#include "bitstream.h"
+#include "traits.h"
+
+namespace arith {
+
+// N states are interleaved: the k-th symbol is coded with state k % N.
+// Since rANS works in LIFO order, the encoder buffers the symbols of a block and codes them backwards when the block is full.
+template <int N = 2>
+struct RansCoder {
+	typedef uint32_t FreqType;
+
+	static const int PROB_BITS = 31;
+	static const uint64_t PROB_SCALE = uint64_t(1) << PROB_BITS; // totals must not exceed PROB_SCALE
+	static const uint64_t RANS_L = uint64_t(1) << 31; // lower bound of the state interval [RANS_L, RANS_L << 32)
+	static const std::size_t BLOCK = 1 << 16; // number of symbols per block
+
+	// maps a cumulative frequency of a model with total t onto [0, PROB_SCALE]
+	static uint64_t scale(FreqType c, FreqType t)
+	{
+		return (uint64_t(c) << PROB_BITS) / t;
+	}
+	// same as scale() for t = 2^bits
+	static uint64_t scale_pow2(FreqType c, int bits)
+	{
+		return uint64_t(c) << (PROB_BITS - bits);
+	}
+};
+
+template <int N = 2>
+struct RansEncoder : RansCoder<N> {
+	typedef uint32_t TF;
+	using RansCoder<N>::PROB_BITS;
+	using RansCoder<N>::RANS_L;
+	using RansCoder<N>::BLOCK;
+	using RansCoder<N>::scale;
+	using RansCoder<N>::scale_pow2;
+
+	struct Sym {
+		uint32_t start, freq;
+	};
+
+	std::vector<Sym> syms;
+	std::vector<uint32_t> words;
+	byteostream os;
+	bool flushed;
+
+	RansEncoder(std::ostream &_os) : os(_os), flushed(false)
+	{
+		syms.reserve(BLOCK);
+	}
+	RansEncoder(std::vector<unsigned char> &_out) : os(_out), flushed(false)
+	{
+		syms.reserve(BLOCK);
+	}
+
+	~RansEncoder()
+	{
+		flush();
+	}
+
+	RansEncoder(const RansEncoder&) = delete;
+	RansEncoder &operator=(const RansEncoder&) = delete;
+
+	void flush()
+	{
+		if (flushed) return;
+		flushed = true;
+
+		encode_block();
+		os.flush();
+	}
+
+	void operator()(TF l, TF h, TF t)
+	{
+		push(scale(l, t), scale(h, t));
+	}
+	void pow2(TF l, TF h, int bits) // same as operator() with t = 2^bits
+	{
+		push(scale_pow2(l, bits), scale_pow2(h, bits));
+	}
+	void bypass(TF v, int bits) // codes the lowest bits of v (at most 16) with equal probabilities
+	{
+		pow2(v, v + 1, bits);
+	}
+	void bit(int v, TF p0, int bits) // codes a binary decision, p0 / 2^bits is the probability of 0
+	{
+		if (v) pow2(p0, TF(1) << bits, bits);
+		else pow2(0, p0, bits);
+	}
+	template <typename S>
+	void operator()(S &freq, typename S::SymType s)
+	{
+		TF l, h;
+		freq.range(s, l, h);
+		if (total_bits<S>::value) pow2(l, h, total_bits<S>::value);
+		else (*this)(l, h, freq.total());
+	}
+
+private:
+	void push(uint64_t sl, uint64_t sh)
+	{
+		syms.push_back(Sym{ (uint32_t)sl, (uint32_t)(sh - sl) });
+		if (syms.size() == BLOCK) encode_block();
+	}
+	void encode_block()
+	{
+		if (syms.empty()) return;
+
+		uint64_t x[N];
+		for (int j = 0; j < N; ++j) x[j] = RANS_L;
+
+		words.clear();
+		for (std::size_t k = syms.size(); k-- > 0;) {
+			uint64_t &s = x[k % N];
+			const Sym &sym = syms[k];
+			uint64_t x_max = ((RANS_L >> PROB_BITS) << 32) * sym.freq;
+			if (s >= x_max) {
+				words.push_back((uint32_t)s);
+				s >>= 32;
+			}
+			s = ((s / sym.freq) << PROB_BITS) + (s % sym.freq) + sym.start;
+		}
+
+		// the decoder reads the final states first, followed by the renormalization words in reverse order
+		for (int j = 0; j < N; ++j) {
+			write_word(x[j]);
+			write_word(x[j] >> 32);
+		}
+		for (std::size_t k = words.size(); k-- > 0;) {
+			write_word(words[k]);
+		}
+		syms.clear();
+	}
+
+	void write_word(uint32_t w)
+	{
+		os.put(w); os.put(w >> 8); os.put(w >> 16); os.put(w >> 24);
+	}
+};
+
+template <int N = 2>
+struct RansDecoder : RansCoder<N> {
+	typedef uint32_t TF;
+	using RansCoder<N>::PROB_BITS;
+	using RansCoder<N>::PROB_SCALE;
+	using RansCoder<N>::RANS_L;
+	using RansCoder<N>::BLOCK;
+	using RansCoder<N>::scale;
+	using RansCoder<N>::scale_pow2;
+
+	uint64_t x[N];
+	std::size_t k; // index of the current symbol within the block
+	byteistream is;
+
+	RansDecoder(std::istream &_is) : k(0), is(_is)
+	{}
+	RansDecoder(const unsigned char *data, std::size_t size) : k(0), is(data, size)
+	{}
+
+	RansDecoder(const RansDecoder&) = delete;
+	RansDecoder &operator=(const RansDecoder&) = delete;
+
+	TF decode_target(TF t)
+	{
+		return ((slot() + 1) * t - 1) >> PROB_BITS; // inverse of scale()
+	}
+	TF decode_target_pow2(int bits) // same as decode_target with t = 2^bits
+	{
+		return slot() >> (PROB_BITS - bits);
+	}
+
+	void operator()(TF l, TF h, TF t)
+	{
+		update(scale(l, t), scale(h, t));
+	}
+	void pow2(TF l, TF h, int bits)
+	{
+		update(scale_pow2(l, bits), scale_pow2(h, bits));
+	}
+	TF bypass(int bits)
+	{
+		TF v = decode_target_pow2(bits);
+		pow2(v, v + 1, bits);
+		return v;
+	}
+	int bit(TF p0, int bits)
+	{
+		int v = decode_target_pow2(bits) >= p0;
+		if (v) pow2(p0, TF(1) << bits, bits);
+		else pow2(0, p0, bits);
+		return v;
+	}
+	template <typename S>
+	typename S::SymType operator()(S &freq)
+	{
+		TF l, h;
+		if (total_bits<S>::value) {
+			TF target = decode_target_pow2(total_bits<S>::value);
+			typename S::SymType s = freq.symbol(target, l, h);
+			pow2(l, h, total_bits<S>::value);
+			return s;
+		}
+		TF t = freq.total();
+		TF target = decode_target(t);
+		typename S::SymType s = freq.symbol(target, l, h);
+		(*this)(l, h, t);
+		return s;
+	}
+
+private:
+	uint64_t slot()
+	{
+		if (k == 0) {
+			for (int j = 0; j < N; ++j) {
+				x[j] = read_word();
+				x[j] |= uint64_t(read_word()) << 32;
+			}
+		}
+		return x[k % N] & (PROB_SCALE - 1);
+	}
+	void update(uint64_t sl, uint64_t sh)
+	{
+		uint64_t &s = x[k % N];
+		s = (sh - sl) * (s >> PROB_BITS) + (s & (PROB_SCALE - 1)) - sl;
+		if (s < RANS_L) s = (s << 32) | read_word();
+		if (++k == BLOCK) k = 0;
+	}
+	uint32_t read_word()
+	{
+		uint32_t w = is.get();
+		w |= uint32_t(is.get()) << 8;
+		w |= uint32_t(is.get()) << 16;
+		w |= uint32_t(is.get()) << 24;
+		return w;
+	}
+};
+
+}
@@ -36,8 +36,9 @@ struct AdaptiveStatisticsModule {
 	std::vector<TF> F, C;
 	TC n;
 	TS mid;
+	TF tot; // cached total, equals cumulative(n - 1)
 
-	AdaptiveStatisticsModule(TC _n = 256) : F(_n, 0), C(_n, 0), n(_n), mid(msb(_n))
+	AdaptiveStatisticsModule(TC _n = 256) : F(_n, 0), C(_n, 0), n(_n), mid(msb(_n)), tot(0)
 	{}
 
 	AdaptiveStatisticsModule(const AdaptiveStatisticsModule&) = delete;
@@ -50,7 +51,7 @@ struct AdaptiveStatisticsModule {
 	}
 	TF total() const
 	{
-		return cumulative(n - 1);
+		return tot;
 	}
 	TS symbol(TF target, TF &l, TF &h)
 	{
@@ -78,7 +79,7 @@ struct AdaptiveStatisticsModule {
 	{
 		inc_impl(s, inc);
 
-		if (total() > FFULL) halve();
+		if (tot > FFULL) halve();
 	}
 	TF frequency(TS s) const
 	{
@@ -90,9 +91,12 @@ struct AdaptiveStatisticsModule {
 	}
 	void halve()
 	{
+		tot = 0;
 		for (TS i = 0; i < n; ++i) {
-			inc_impl(i, -(frequency(i) >> 1));
+			C[i] -= C[i] >> 1;
+			tot += C[i];
 		}
+		build();
 	}
 	TF cumulative(TS s) const
 	{
@@ -122,6 +126,18 @@ private:
 			i = forward(i);
 		}
 		C[s] += inc;
+		tot += inc;
+	}
+	// rebuilds the tree from C in O(n): every node passes its sum on to its parent
+	void build()
+	{
+		for (TS i = 0; i < n; ++i) {
+			F[i] = C[i];
+		}
+		for (TS i = 1; i <= n; ++i) {
+			TS j = forward(i);
+			if (j <= n) F[j - 1] += F[i - 1];
+		}
 	}
 };
 
@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2017, Max von Buelow
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+namespace arith {
+
+// Adaptive statistics module for alphabets of up to 256 symbols with compact counters: only the frequencies C and the sums GS of G = 16 groups of G symbols are stored, as TI (16 bit by default), about 560 bytes in total.
+// The cumulative frequencies are derived from C and GS by loops with a fixed trip count of G, so inc() is O(1) and range() and symbol() add up at most 2G counters without data-dependent branches.
+// The total is kept at most FFULL = 2^(bits of TI - 2) by halving.
+template <typename TF = uint64_t, typename TS = uint32_t, typename TC = uint32_t, typename TI = uint16_t>
+struct CompactStatisticsModule {
+	typedef TF FreqType;
+	typedef TS SymType;
+	typedef TC CountType;
+
+	static const int b = sizeof(TI) * 8;
+	static const int f = b - 2;
+	static const TI FFULL = TI(1) << f;
+	static const TC G = 16;
+
+	TI C[G * G], GS[G];
+	TI tot;
+	TC n;
+
+	CompactStatisticsModule(TC _n = G * G) : tot(0), n(_n)
+	{
+#ifdef HAVE_ASSERT
+		assert_le(n, G * G);
+#endif
+		for (TC i = 0; i < G * G; ++i) {
+			C[i] = 0;
+		}
+		for (TC i = 0; i < G; ++i) {
+			GS[i] = 0;
+		}
+	}
+
+	CompactStatisticsModule(const CompactStatisticsModule&) = delete;
+	CompactStatisticsModule &operator=(const CompactStatisticsModule&) = delete;
+
+	void range(TS s, TF &l, TF &h)
+	{
+		TC g = s / G, k = s % G;
+		const TI *c = C + g * G;
+		TI acc = 0;
+		for (TC i = 0; i < G; ++i) {
+			acc += i < g ? GS[i] : 0;
+		}
+		for (TC i = 0; i < G; ++i) {
+			acc += i < k ? c[i] : 0;
+		}
+		l = acc;
+		h = acc + C[s];
+	}
+	TF total() const
+	{
+		return tot;
+	}
+	TS symbol(TF target, TF &l, TF &h)
+	{
+		// most byte models are dominated by symbol 0
+		if (target < C[0]) {
+			l = 0;
+			h = C[0];
+			return 0;
+		}
+
+		// the group (symbol) is the number of inclusive prefix sums <= target, the lower bound is the sum of the counts skipped
+		TI t = target, acc = 0, base = 0;
+		TC g = 0;
+		for (TC i = 0; i < G - 1; ++i) {
+			acc += GS[i];
+			bool skip = acc <= t;
+			g += skip;
+			base += skip ? GS[i] : 0;
+		}
+		t -= base;
+		const TI *c = C + g * G;
+		TI acc2 = 0, base2 = 0;
+		TC k = 0;
+		for (TC i = 0; i < G - 1; ++i) {
+			acc2 += c[i];
+			bool skip = acc2 <= t;
+			k += skip;
+			base2 += skip ? c[i] : 0;
+		}
+		TS s = g * G + k;
+		l = base + base2;
+		h = l + C[s];
+		return s;
+	}
+	void init(TS s, TF incr = 1)
+	{
+		inc(s, incr);
+	}
+	void inc(TS s, TF inc = 1)
+	{
+		C[s] += inc;
+		GS[s / G] += inc;
+		tot += inc;
+
+		if (tot > FFULL) halve();
+	}
+	TF frequency(TS s) const
+	{
+		return C[s];
+	}
+	void set(TS s, TF f)
+	{
+		TI d = TI(f) - C[s];
+		C[s] += d;
+		GS[s / G] += d;
+		tot += d;
+	}
+	void halve()
+	{
+		tot = 0;
+		for (TC g = 0; g < G; ++g) {
+			TI gs = 0;
+			for (TC i = g * G; i < (g + 1) * G; ++i) {
+				C[i] -= C[i] >> 1;
+				gs += C[i];
+			}
+			GS[g] = gs;
+			tot += gs;
+		}
+	}
+};
+
+}
@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2017, Max von Buelow
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <stdint.h>
+
+namespace arith {
+
+// Adaptive statistics module whose total is always 2^BITS, so that the coders can replace the division by the total by a shift (see total_bits).
+// The adaptive counts C are rescaled to the cumulative table N periodically; the period grows with the sum of the counts up to 4n increments.
+// Every symbol with a nonzero count keeps a nonzero frequency, hence at most 2^BITS symbols can be initialized.
+template <typename TF = uint32_t, typename TS = uint32_t, typename TC = uint32_t, int BITS = 16>
+struct Pow2StatisticsModule {
+	typedef TF FreqType;
+	typedef TS SymType;
+	typedef TC CountType;
+
+	static const int TOTAL_BITS = BITS;
+	static const TF TOTAL = TF(1) << BITS;
+	static const int RESCALE_SHIFT = 7; // rescale after sum / 2^RESCALE_SHIFT increments
+	static const int b = sizeof(TF) * 8;
+	static const int f = b - 2;
+	static const TF FFULL = TF(1) << f;
+
+	std::vector<TF> C, N; // adaptive counts and normalized cumulative frequencies
+	TC n;
+	TF sum; // sum of the adaptive counts
+	TC since, period; // number of increments since the last rescale
+	bool dirty;
+
+	Pow2StatisticsModule(TC _n = 256) : C(_n, 0), N(_n + 1, 0), n(_n), sum(0), since(0), period(1), dirty(false)
+	{}
+
+	Pow2StatisticsModule(const Pow2StatisticsModule&) = delete;
+	Pow2StatisticsModule &operator=(const Pow2StatisticsModule&) = delete;
+
+	void range(TS s, TF &l, TF &h)
+	{
+		if (dirty) rescale();
+		l = N[s];
+		h = N[s + 1];
+	}
+	TF total() const
+	{
+		return TOTAL;
+	}
+	TS symbol(TF target, TF &l, TF &h)
+	{
+		if (dirty) rescale();
+		TS s = std::upper_bound(N.begin() + 1, N.end(), target) - N.begin() - 1;
+		l = N[s];
+		h = N[s + 1];
+		return s;
+	}
+	void init(TS s, TF incr = 1)
+	{
+		inc(s, incr);
+	}
+	void inc(TS s, TF inc = 1)
+	{
+		// a new symbol has to be codable immediately
+		if (C[s] == 0) dirty = true;
+		C[s] += inc;
+		sum += inc;
+
+		if (sum > FFULL) halve();
+		if (++since >= period) dirty = true;
+	}
+	TF frequency(TS s) const
+	{
+		return C[s];
+	}
+	void set(TS s, TF f)
+	{
+		sum = sum - C[s] + f;
+		C[s] = f;
+		dirty = true;
+	}
+	void halve()
+	{
+		sum = 0;
+		for (TS i = 0; i < n; ++i) {
+			C[i] -= C[i] >> 1;
+			sum += C[i];
+		}
+		dirty = true;
+	}
+
+private:
+	void rescale()
+	{
+		dirty = false;
+		since = 0;
+		period = std::min<TF>(std::max<TF>(sum >> RESCALE_SHIFT, 1), n * 4);
+
+		TC active = 0;
+		TS top = 0;
+		for (TS i = 0; i < n; ++i) {
+			if (C[i] == 0) continue;
+			++active;
+			if (C[i] > C[top]) top = i;
+		}
+		if (active == 0) return;
+
+		// every active symbol gets 1 plus its share of the remaining TOTAL - active
+		uint64_t mul = (uint64_t(TOTAL - active) << 32) / sum;
+		TF cum = 0;
+		for (TS i = 0; i < n; ++i) {
+			N[i] = cum;
+			if (C[i] != 0) cum += 1 + TF((C[i] * mul) >> 32);
+		}
+		N[n] = cum;
+
+		// the rounding remainder is assigned to the most frequent symbol
+		TF rem = TOTAL - cum;
+		for (TS i = top + 1; i <= n; ++i) {
+			N[i] += rem;
+		}
+	}
+};
+
+}
@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2017, Max von Buelow
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+namespace arith {
+
+// Adaptive statistics module for tiny alphabets of up to MAXN symbols, e.g. the operations of the Cut-Border Machine.
+// The counts are stored in a fixed array without any tree: inc() and set() are O(1), range() and symbol() sum up the MAXN counts in loops with a fixed trip count.
+// The total is kept at most 2^FBITS, which has to be lowered for coders whose totals are limited more than by the width of TF (e.g. the 32 bit range coder).
+template <typename TF = uint64_t, typename TS = uint32_t, typename TC = uint32_t, int MAXN = 8, int FBITS = sizeof(TF) * 8 - 2>
+struct SmallStatisticsModule {
+	typedef TF FreqType;
+	typedef TS SymType;
+	typedef TC CountType;
+
+	static const int b = sizeof(TF) * 8;
+	static const int f = FBITS;
+	static const TF FFULL = TF(1) << f;
+
+	TF C[MAXN];
+	TF tot;
+	TC n;
+
+	SmallStatisticsModule(TC _n = MAXN) : tot(0), n(_n)
+	{
+#ifdef HAVE_ASSERT
+		assert_le(n, MAXN);
+#endif
+		for (int i = 0; i < MAXN; ++i) {
+			C[i] = 0;
+		}
+	}
+
+	SmallStatisticsModule(const SmallStatisticsModule&) = delete;
+	SmallStatisticsModule &operator=(const SmallStatisticsModule&) = delete;
+
+	void range(TS s, TF &l, TF &h)
+	{
+		TF acc = 0;
+		for (int i = 0; i < MAXN; ++i) {
+			acc += (TS)i < s ? C[i] : 0;
+		}
+		l = acc;
+		h = acc + C[s];
+	}
+	TF total() const
+	{
+		return tot;
+	}
+	TS symbol(TF target, TF &l, TF &h)
+	{
+		// the number of inclusive prefix sums <= target is the symbol; symbols with a frequency of 0 are skipped automatically
+		TF acc = 0;
+		TS s = 0;
+		for (int i = 0; i < MAXN - 1; ++i) {
+			acc += C[i];
+			s += acc <= target;
+		}
+		range(s, l, h);
+		return s;
+	}
+	void init(TS s, TF incr = 1)
+	{
+		inc(s, incr);
+	}
+	void inc(TS s, TF inc = 1)
+	{
+		C[s] += inc;
+		tot += inc;
+
+		if (tot > FFULL) halve();
+	}
+	TF frequency(TS s) const
+	{
+		return C[s];
+	}
+	void set(TS s, TF f)
+	{
+		tot = tot - C[s] + f;
+		C[s] = f;
+	}
+	void halve()
+	{
+		tot = 0;
+		for (int i = 0; i < MAXN; ++i) {
+			C[i] -= C[i] >> 1;
+			tot += C[i];
+		}
+	}
+};
+
+}
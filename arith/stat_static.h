@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2017, Max von Buelow
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+#pragma once
+
+#include <vector>
+#include <stdint.h>
+
+namespace arith {
+
+// Gathers the symbol counts of a first (encoding) pass, from which StaticStatisticsModule tables are built; it does not provide meaningful probabilities
+template <typename TF = uint64_t, typename TS = uint32_t, typename TC = uint32_t>
+struct HistogramModule {
+	typedef TF FreqType;
+	typedef TS SymType;
+	typedef TC CountType;
+
+	std::vector<uint64_t> H;
+	TC n;
+
+	HistogramModule(TC _n = 256) : H(_n, 0), n(_n)
+	{}
+
+	HistogramModule(const HistogramModule&) = delete;
+	HistogramModule &operator=(const HistogramModule&) = delete;
+
+	void range(TS s, TF &l, TF &h)
+	{
+		l = 0;
+		h = 1;
+	}
+	TF total() const
+	{
+		return 1;
+	}
+	TS symbol(TF target, TF &l, TF &h)
+	{
+		range(0, l, h);
+		return 0;
+	}
+	void init(TS s, TF incr = 1)
+	{}
+	void inc(TS s, TF inc = 1)
+	{
+		H[s] += inc;
+	}
+	TF frequency(TS s) const
+	{
+		return H[s];
+	}
+};
+
+// Semi-static statistics module for alphabets of up to 256 symbols: the frequencies are loaded once from a table normalized to 2^BITS and never change.
+// init() and inc() are no-ops, symbol() is a single lookup in a table of 2^BITS entries and the total is a power of 2 (see total_bits).
+template <typename TF = uint64_t, typename TS = uint32_t, typename TC = uint32_t, int BITS = 12>
+struct StaticStatisticsModule {
+	typedef TF FreqType;
+	typedef TS SymType;
+	typedef TC CountType;
+
+	static const int TOTAL_BITS = BITS;
+	static const uint32_t TOTAL = uint32_t(1) << BITS;
+	static const TC MAXN = 256;
+
+	TF N[MAXN + 1]; // cumulative frequencies
+	uint8_t lut[TOTAL]; // symbol of every target
+	TC n;
+
+	StaticStatisticsModule(TC _n = MAXN) : n(_n)
+	{
+#ifdef HAVE_ASSERT
+		assert_le(n, MAXN);
+#endif
+		for (TC i = 0; i <= n; ++i) {
+			N[i] = 0;
+		}
+	}
+
+	StaticStatisticsModule(const StaticStatisticsModule&) = delete;
+	StaticStatisticsModule &operator=(const StaticStatisticsModule&) = delete;
+
+	// freq holds n frequencies summing up to TOTAL (or to 0 for a module that is never used)
+	void load(const uint32_t *freq)
+	{
+		TF cum = 0;
+		for (TC i = 0; i < n; ++i) {
+			N[i] = cum;
+			for (uint32_t j = 0; j < freq[i]; ++j) {
+				lut[cum + j] = i;
+			}
+			cum += freq[i];
+		}
+		N[n] = cum;
+	}
+
+	// Scales the histogram hist of n symbols to TOTAL, such that every symbol with a nonzero count keeps a nonzero frequency
+	static void normalize(const uint64_t *hist, TC n, uint32_t *freq)
+	{
+		uint64_t sum = 0;
+		TC active = 0, top = 0;
+		for (TC i = 0; i < n; ++i) {
+			sum += hist[i];
+			if (hist[i] != 0) ++active;
+			if (hist[i] > hist[top]) top = i;
+		}
+		if (active == 0) {
+			for (TC i = 0; i < n; ++i) freq[i] = 0;
+			return;
+		}
+
+		// every active symbol gets 1 plus its share of the remaining TOTAL - active, the rounding remainder goes to the most frequent symbol
+		uint32_t cum = 0;
+		for (TC i = 0; i < n; ++i) {
+			freq[i] = hist[i] == 0 ? 0 : 1 + uint32_t((unsigned __int128)hist[i] * (TOTAL - active) / sum);
+			cum += freq[i];
+		}
+		freq[top] += TOTAL - cum;
+	}
+
+	void range(TS s, TF &l, TF &h)
+	{
+		l = N[s];
+		h = N[s + 1];
+	}
+	TF total() const
+	{
+		return TOTAL;
+	}
+	TS symbol(TF target, TF &l, TF &h)
+	{
+		TS s = lut[target];
+		l = N[s];
+		h = N[s + 1];
+		return s;
+	}
+	void init(TS s, TF incr = 1)
+	{}
+	void inc(TS s, TF inc = 1)
+	{}
+	TF frequency(TS s) const
+	{
+		return N[s + 1] - N[s];
+	}
+};
+
+}
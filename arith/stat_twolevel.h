@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2017, Max von Buelow
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+#pragma once
+
+#include <vector>
+#include <stdint.h>
+
+namespace arith {
+
+// Adaptive statistics module for alphabets of up to 256 symbols with a two-level cumulative table: the symbols are split into G = 16 groups of G symbols.
+// GC holds the exclusive prefix sums of the groups and P the exclusive prefix sums within each group.
+// range() is O(1), inc() adds to 2G contiguous entries, and symbol() counts the entries <= target in two contiguous arrays of G entries, all without data-dependent branches.
+// Unused symbols (n < 256) simply have a frequency of 0.
+// The tables are stored as TI, which may be narrower (but not wider) than the frequency type TF of the coder; 32 bit tables halve the memory traffic of inc() compared to 64 bit ones.
+// Until the total exceeds FFULL = 2^(bits of TI - 2), the frequencies are exactly those of AdaptiveStatisticsModule.
+template <typename TF = uint64_t, typename TS = uint32_t, typename TC = uint32_t, typename TI = uint32_t>
+struct TwoLevelStatisticsModule {
+	typedef TF FreqType;
+	typedef TS SymType;
+	typedef TC CountType;
+
+	static const int b = sizeof(TI) * 8;
+	static const int f = b - 2;
+	static const TI FFULL = TI(1) << f;
+	static const TC G = 16;
+
+	std::vector<TI> C, P, GC;
+	TC n;
+
+	TwoLevelStatisticsModule(TC _n = 256) : C(G * G, 0), P(G * G, 0), GC(G + 1, 0), n(_n)
+	{
+#ifdef HAVE_ASSERT
+		assert_le(n, G * G);
+#endif
+	}
+
+	TwoLevelStatisticsModule(const TwoLevelStatisticsModule&) = delete;
+	TwoLevelStatisticsModule &operator=(const TwoLevelStatisticsModule&) = delete;
+
+	void range(TS s, TF &l, TF &h)
+	{
+		l = GC[s / G] + P[s];
+		h = l + C[s];
+	}
+	TF total() const
+	{
+		return GC[G];
+	}
+	TS symbol(TF target, TF &l, TF &h)
+	{
+		// the number of prefix sums <= target is the index of the last group (symbol) starting at or before target; empty groups (symbols) are skipped automatically
+		// most byte models are dominated by symbol 0
+		if (target < C[0]) {
+			l = 0;
+			h = C[0];
+			return 0;
+		}
+
+		TI t = target; // target < total, so it fits into TI and the comparisons stay in the width of the tables
+		const TI *gc = GC.data();
+		TI g = 0;
+		for (TC i = 1; i < G; ++i) {
+			g += gc[i] <= t;
+		}
+		t -= gc[g];
+		const TI *p = P.data() + g * G;
+		TI k = 0;
+		for (TC i = 1; i < G; ++i) {
+			k += p[i] <= t;
+		}
+		TS s = g * G + k;
+		l = gc[g] + p[k];
+		h = l + C[s];
+		return s;
+	}
+	void init(TS s, TF incr = 1)
+	{
+		inc(s, incr);
+	}
+	void inc(TS s, TF inc = 1)
+	{
+		inc_impl(s, inc);
+
+		if (total() > FFULL) halve();
+	}
+	TF frequency(TS s) const
+	{
+		return C[s];
+	}
+	void set(TS s, TF f)
+	{
+		inc_impl(s, -frequency(s) + f);
+	}
+	void halve()
+	{
+		TI cum = 0;
+		for (TC g = 0; g < G; ++g) {
+			GC[g] = cum;
+			TI gcum = 0;
+			for (TC i = g * G; i < (g + 1) * G; ++i) {
+				C[i] -= C[i] >> 1;
+				P[i] = gcum;
+				gcum += C[i];
+			}
+			cum += gcum;
+		}
+		GC[G] = cum;
+	}
+
+private:
+	void inc_impl(TS s, TI inc)
+	{
+		// fixed trip counts with masks instead of loops depending on s: no branch mispredictions and vectorizable
+		C[s] += inc;
+		TC g = s / G, k = s % G;
+		TI *p = P.data() + g * G, *gc = GC.data();
+		for (TC i = 0; i < G; ++i) {
+			p[i] += i > k ? inc : 0;
+		}
+		for (TC i = 0; i <= G; ++i) {
+			gc[i] += i > g ? inc : 0;
+		}
+	}
+};
+
+}
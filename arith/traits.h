@@ -0,0 +1,23 @@
+/*
+ * Copyright (C) 2017, Max von Buelow
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+#pragma once
+
+namespace arith {
+
+// Statistics modules whose total is constantly 2^TOTAL_BITS expose TOTAL_BITS; the coders then replace the division by the total by a shift.
+template <typename S, typename = void>
+struct total_bits {
+	static const int value = 0;
+};
+template <typename S>
+struct total_bits<S, decltype((void)S::TOTAL_BITS)> {
+	static const int value = S::TOTAL_BITS;
+};
+
+}
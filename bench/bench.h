@@ -0,0 +1,46 @@
+/*
+ * Copyright (C) 2017, Max von Buelow
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <stdint.h>
+
+namespace bench {
+
+// Runs f repeatedly for at least min_seconds and returns the seconds per run
+template <typename F>
+double measure(F f, double min_seconds = 0.2)
+{
+	typedef std::chrono::steady_clock clock;
+	f(); // warm up
+	int runs = 0;
+	clock::time_point start = clock::now();
+	double elapsed;
+	do {
+		f();
+		++runs;
+		elapsed = std::chrono::duration<double>(clock::now() - start).count();
+	} while (elapsed < min_seconds);
+	return elapsed / runs;
+}
+
+inline void report(const char *name, uint64_t ops, double seconds)
+{
+	std::printf("%-40s %10.2f Mops/s %10.3f ms\n", name, ops / seconds * 1e-6, seconds * 1e3);
+}
+
+// Prevents the compiler from optimizing away a computed value
+template <typename T>
+inline void keep(const T &v)
+{
+	asm volatile("" : : "g"(&v) : "memory");
+}
+
+}
@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2017, Max von Buelow
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+/*
+ * Benchmark of the entropy coders in isolation: symbols per second for encoding and decoding, and bits per symbol, for several alphabet sizes, distributions and frequency widths.
+ */
+
+#include <vector>
+#include <string>
+#include <random>
+#include <cmath>
+#include <algorithm>
+#include <cstdio>
+
+#include "bench.h"
+#include "arith/coder.h"
+#include "arith/rangecoder.h"
+#include "arith/rans.h"
+#include "arith/stat_adaptive.h"
+#include "arith/stat_twolevel.h"
+
+static const int NSYMS = 1 << 20;
+
+enum Dist { UNIFORM, GEOMETRIC, ZIPF };
+static const char *dist2str(Dist d)
+{
+	static const char *lut[] = { "uniform", "geometric", "zipf" };
+	return lut[d];
+}
+
+static std::vector<uint32_t> generate(Dist d, uint32_t n)
+{
+	std::mt19937 rng(42);
+	std::vector<uint32_t> syms(NSYMS);
+	switch (d) {
+	case UNIFORM: {
+		std::uniform_int_distribution<uint32_t> dist(0, n - 1);
+		for (uint32_t &s : syms) s = dist(rng);
+		break;
+	}
+	case GEOMETRIC: {
+		// mean of about n / 16 symbols, at least 1
+		std::geometric_distribution<uint32_t> dist(std::min(0.5, 16.0 / n));
+		for (uint32_t &s : syms) s = std::min(dist(rng), n - 1);
+		break;
+	}
+	case ZIPF: {
+		// P(k) ~ 1 / (k + 1)^1.1
+		std::vector<double> cdf(n);
+		double sum = 0;
+		for (uint32_t k = 0; k < n; ++k) {
+			sum += 1.0 / std::pow(k + 1, 1.1);
+			cdf[k] = sum;
+		}
+		std::uniform_real_distribution<double> dist(0, sum);
+		for (uint32_t &s : syms) s = std::min<uint32_t>(std::lower_bound(cdf.begin(), cdf.end(), dist(rng)) - cdf.begin(), n - 1);
+		break;
+	}
+	}
+	return syms;
+}
+
+template <typename E, typename D, typename S>
+void run(const char *name, Dist d, uint32_t n, const std::vector<uint32_t> &syms)
+{
+	std::vector<unsigned char> buf;
+	double te = bench::measure([&]() {
+		buf.clear();
+		S stat(n);
+		for (uint32_t i = 0; i < n; ++i) stat.init(i);
+		E enc(buf);
+		for (uint32_t s : syms) {
+			enc(stat, s);
+			stat.inc(s);
+		}
+		enc.flush();
+	});
+
+	bool ok = true;
+	double td = bench::measure([&]() {
+		S stat(n);
+		for (uint32_t i = 0; i < n; ++i) stat.init(i);
+		D dec(buf.data(), buf.size());
+		for (uint32_t s : syms) {
+			uint32_t r = dec(stat);
+			stat.inc(r);
+			ok &= r == s;
+		}
+	});
+
+	std::printf("%-16s %-10s %6u %10.2f %10.2f %10.4f%s\n", name, dist2str(d), n, syms.size() / te * 1e-6, syms.size() / td * 1e-6, buf.size() * 8.0 / syms.size(), ok ? "" : "  MISMATCH");
+}
+
+int main()
+{
+	std::printf("%-16s %-10s %6s %10s %10s %10s\n", "coder", "dist", "n", "enc Msym/s", "dec Msym/s", "bits/sym");
+
+	const uint32_t sizes[] = { 8, 256, 65536 };
+	const Dist dists[] = { UNIFORM, GEOMETRIC, ZIPF };
+	for (uint32_t n : sizes) {
+		for (Dist d : dists) {
+			std::vector<uint32_t> syms = generate(d, n);
+			run<arith::Encoder<uint64_t>, arith::Decoder<uint64_t>, arith::AdaptiveStatisticsModule<uint64_t>>("arith<u64>", d, n, syms);
+			run<arith::Encoder<uint32_t>, arith::Decoder<uint32_t>, arith::AdaptiveStatisticsModule<uint32_t>>("arith<u32>", d, n, syms);
+			run<arith::RangeEncoder<uint64_t>, arith::RangeDecoder<uint64_t>, arith::AdaptiveStatisticsModule<uint64_t>>("range<u64>", d, n, syms);
+			if (n <= 256) {
+				// the 32 bit range coder limits totals to 2^24, its natural partner are 16 bit two-level tables
+				run<arith::RangeEncoder<uint64_t>, arith::RangeDecoder<uint64_t>, arith::TwoLevelStatisticsModule<uint64_t>>("range<u64> 2l", d, n, syms);
+				run<arith::RangeEncoder<uint32_t>, arith::RangeDecoder<uint32_t>, arith::TwoLevelStatisticsModule<uint32_t, uint32_t, uint32_t, uint16_t>>("range<u32> 2l16", d, n, syms);
+			}
+			run<arith::RansEncoder<>, arith::RansDecoder<>, arith::AdaptiveStatisticsModule<uint32_t>>("rans<u32>", d, n, syms);
+		}
+	}
+}
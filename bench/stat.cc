@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2017, Max von Buelow
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+/*
+ * Microbenchmark of the statistics modules: the operations a ModelMult byte model performs per coded symbol, without the coder.
+ */
+
+#include <vector>
+#include <random>
+#include <algorithm>
+
+#include "bench.h"
+#include "arith/stat_adaptive.h"
+#include "arith/stat_pow2.h"
+#include "arith/stat_twolevel.h"
+#include "arith/stat_small.h"
+#include "arith/stat_compact.h"
+#include "arith/adapt.h"
+
+static const int NSYMS = 1 << 20;
+
+static std::vector<uint32_t> geometric(double p)
+{
+	std::mt19937 rng(42);
+	std::geometric_distribution<uint32_t> dist(p);
+	std::vector<uint32_t> syms(NSYMS);
+	for (uint32_t &s : syms) s = std::min<uint32_t>(dist(rng), 255);
+	return syms;
+}
+
+// encoder side: range() and inc() per symbol
+template <typename S>
+void bench_encode(const char *name, const std::vector<uint32_t> &syms, typename S::FreqType incr)
+{
+	double t = bench::measure([&]() {
+		S stat(256);
+		for (int i = 0; i < 256; ++i) stat.init(i);
+		typename S::FreqType l, h, acc = 0;
+		for (uint32_t s : syms) {
+			stat.range(s, l, h);
+			acc += h - l + stat.total();
+			stat.inc(s, incr);
+		}
+		bench::keep(acc);
+	});
+	bench::report(name, syms.size(), t);
+}
+
+// decoder side: symbol() and inc() per symbol; the targets are taken from the encoder side
+template <typename S>
+void bench_decode(const char *name, const std::vector<uint32_t> &syms, typename S::FreqType incr)
+{
+	std::vector<typename S::FreqType> targets(syms.size());
+	{
+		S stat(256);
+		for (int i = 0; i < 256; ++i) stat.init(i);
+		typename S::FreqType l, h;
+		for (std::size_t i = 0; i < syms.size(); ++i) {
+			stat.range(syms[i], l, h);
+			targets[i] = l;
+			stat.inc(syms[i], incr);
+		}
+	}
+	double t = bench::measure([&]() {
+		S stat(256);
+		for (int i = 0; i < 256; ++i) stat.init(i);
+		typename S::FreqType l, h, acc = 0;
+		for (typename S::FreqType target : targets) {
+			acc += stat.total();
+			typename S::SymType s = stat.symbol(target, l, h);
+			stat.inc(s, incr);
+		}
+		bench::keep(acc);
+	});
+	bench::report(name, syms.size(), t);
+}
+
+// the pattern of CBMModel: two set() calls, one coded symbol and one inc() per symbol over an alphabet of 7
+template <typename S>
+void bench_cbm(const char *name, const std::vector<uint32_t> &syms)
+{
+	double t = bench::measure([&]() {
+		S stat(7);
+		for (int i = 0; i < 7; ++i) stat.init(i);
+		typename S::FreqType l, h, acc = 0, c = 2;
+		for (uint32_t s : syms) {
+			stat.set(5, c / 2 + 1);
+			stat.set(6, c - c / 2);
+			typename S::FreqType target = (s * 2654435761u) % stat.total();
+			acc += stat.symbol(target, l, h);
+			if (s % 7 >= 5) ++c;
+			else stat.inc(s % 7);
+		}
+		bench::keep(acc);
+	});
+	bench::report(name, syms.size(), t);
+}
+
+int main()
+{
+	std::vector<uint32_t> syms = geometric(0.05);
+
+	// no halving within the run
+	bench_encode<arith::AdaptiveStatisticsModule<>>("fenwick<u64> encode", syms, 1);
+	bench_decode<arith::AdaptiveStatisticsModule<>>("fenwick<u64> decode", syms, 1);
+	bench_encode<arith::AdaptiveStatisticsModule<uint32_t>>("fenwick<u32> encode", syms, 1);
+	bench_decode<arith::AdaptiveStatisticsModule<uint32_t>>("fenwick<u32> decode", syms, 1);
+
+	// 16 bit counters halve every few thousand symbols
+	bench_encode<arith::AdaptiveStatisticsModule<uint16_t>>("fenwick<u16> encode (halving)", syms, 8);
+	bench_decode<arith::AdaptiveStatisticsModule<uint16_t>>("fenwick<u16> decode (halving)", syms, 8);
+
+	bench_encode<arith::TwoLevelStatisticsModule<>>("twolevel<u64> encode", syms, 1);
+	bench_decode<arith::TwoLevelStatisticsModule<>>("twolevel<u64> decode", syms, 1);
+	bench_encode<arith::TwoLevelStatisticsModule<uint32_t>>("twolevel<u32> encode", syms, 1);
+	bench_decode<arith::TwoLevelStatisticsModule<uint32_t>>("twolevel<u32> decode", syms, 1);
+	bench_encode<arith::TwoLevelStatisticsModule<uint16_t, uint32_t, uint32_t, uint16_t>>("twolevel<u16> encode (halving)", syms, 8);
+	bench_decode<arith::TwoLevelStatisticsModule<uint16_t, uint32_t, uint32_t, uint16_t>>("twolevel<u16> decode (halving)", syms, 8);
+
+	bench_encode<arith::CompactStatisticsModule<>>("compact<u16> encode (halving)", syms, 8);
+	bench_decode<arith::CompactStatisticsModule<>>("compact<u16> decode (halving)", syms, 8);
+	bench_encode<arith::CompactStatisticsModule<uint64_t, uint32_t, uint32_t, uint32_t>>("compact<u32> encode", syms, 1);
+	bench_decode<arith::CompactStatisticsModule<uint64_t, uint32_t, uint32_t, uint32_t>>("compact<u32> decode", syms, 1);
+
+	// the policy of the HRY residual models: increments of 16, halving at 2^13
+	bench_encode<arith::Adapted<arith::CompactStatisticsModule<>, arith::Adaptation<16, 13>>>("compact<u16> encode (fast adaptation)", syms, 1);
+	bench_decode<arith::Adapted<arith::CompactStatisticsModule<>, arith::Adaptation<16, 13>>>("compact<u16> decode (fast adaptation)", syms, 1);
+
+	bench_encode<arith::Pow2StatisticsModule<>>("pow2<u32> encode", syms, 1);
+	bench_decode<arith::Pow2StatisticsModule<>>("pow2<u32> decode", syms, 1);
+
+	bench_cbm<arith::AdaptiveStatisticsModule<>>("fenwick<u64> cbm", syms);
+	bench_cbm<arith::TwoLevelStatisticsModule<>>("twolevel<u64> cbm", syms);
+	bench_cbm<arith::SmallStatisticsModule<>>("small<u64> cbm", syms);
+}
@@ -0,0 +1,178 @@
+/*
+ * Copyright (C) 2017, Max von Buelow
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+/*
+ * Benchmark of the traversal policies of the HRY encoder: the Cut-Border Machine operations they produce on the given meshes (fewer splits and unions mean fewer bits and shorter searches), their order-0 entropy and the time of the connectivity pass alone.
+ */
+
+#include <vector>
+#include <string>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+
+#include "bench.h"
+#include "formats/unified_reader.h"
+#include "formats/hry/traversal.h"
+#include "cbm/encoder.h"
+#include "tg/encoder.h"
+
+// Counts the operations instead of coding them
+struct Counter {
+	uint64_t ops[cbm::LAST + 1] = {}, iops[cbm::ILAST + 1] = {};
+	uint64_t dist = 0; // sum of the offsets of splits and unions
+
+	void order(int) {}
+	void initial(int) { ++iops[cbm::INIT]; }
+	void tri100(int, mesh::vtxidx_t) { ++iops[cbm::TRI100]; }
+	void tri010(int, mesh::vtxidx_t) { ++iops[cbm::TRI010]; }
+	void tri001(int, mesh::vtxidx_t) { ++iops[cbm::TRI001]; }
+	void tri110(int, mesh::vtxidx_t, mesh::vtxidx_t) { ++iops[cbm::TRI110]; }
+	void tri101(int, mesh::vtxidx_t, mesh::vtxidx_t) { ++iops[cbm::TRI101]; }
+	void tri011(int, mesh::vtxidx_t, mesh::vtxidx_t) { ++iops[cbm::TRI011]; }
+	void tri111(int, mesh::vtxidx_t, mesh::vtxidx_t, mesh::vtxidx_t) { ++iops[cbm::TRI111]; }
+	void end() { ++iops[cbm::EOM]; }
+	void border(cbm::OP op = cbm::BORDER) { ++ops[op]; }
+	void newvertex(int) { ++ops[cbm::NEWVTX]; }
+	void connectforward(int) { ++ops[cbm::CONNFWD]; }
+	void connectbackward(int) { ++ops[cbm::CONNBWD]; }
+	void splitcutborder(int, int i) { ++ops[cbm::SPLIT]; dist += std::abs(i); }
+	void cutborderunion(int, int i, int) { ++ops[cbm::UNION]; dist += std::abs(i); }
+	void nm(int, mesh::vtxidx_t) { ++ops[cbm::NM]; }
+
+	// bits of the operations under an order-0 model
+	double entropy() const
+	{
+		uint64_t n = 0;
+		for (uint64_t c : ops) n += c;
+		double bits = 0;
+		for (uint64_t c : ops) {
+			if (c) bits -= c * std::log2(double(c) / n);
+		}
+		return bits;
+	}
+};
+
+// Counts the operations of the valence coder
+struct TGCounter {
+	uint64_t ops[tg::LAST + 1] = {}, implicit = 0, seeds = 0;
+	uint64_t dist = 0;
+	std::vector<uint64_t> valences;
+
+	void initial(int) { ++seeds; }
+	void end() {}
+	void valence(int d) { if (d >= valences.size()) valences.resize(d + 1, 0); ++valences[d]; }
+	void addvertex(int d) { ++ops[tg::ADD]; valence(d); }
+	void adddummy(int) { ++ops[tg::DUMMY]; }
+	void forward() { ++ops[tg::FWD]; }
+	void backward() { ++ops[tg::BWD]; }
+	void splitlist(int i) { ++ops[tg::SPLIT]; dist += std::abs(i); }
+	void mergelist(int i, int) { ++ops[tg::MERGE]; dist += std::abs(i); }
+
+	// bits of the operations and valences under order-0 models
+	double entropy() const
+	{
+		return order0(ops, tg::LAST + 1) + order0(valences.data(), valences.size());
+	}
+	static double order0(const uint64_t *c, std::size_t k)
+	{
+		uint64_t n = 0;
+		for (std::size_t i = 0; i < k; ++i) n += c[i];
+		double bits = 0;
+		for (std::size_t i = 0; i < k; ++i) {
+			if (c[i]) bits -= c[i] * std::log2(double(c[i]) / n);
+		}
+		return bits;
+	}
+};
+
+struct NoAttrs {
+	void vtx(mesh::faceidx_t, mesh::ledgeidx_t) {}
+	void face(mesh::faceidx_t, mesh::ledgeidx_t) {}
+};
+
+static const char *seed2str(hry::Seed s)
+{
+	static const char *lut[] = { "index", "border" };
+	return lut[s];
+}
+
+static const char *gate2str(cbm::GATE g)
+{
+	static const char *lut[] = { "front", "fuller" };
+	return lut[g];
+}
+
+static void run(const std::string &fn, hry::Seed seed, cbm::GATE gate)
+{
+	// the encoder fixes the twins of the mesh, so every run reads it again
+	mesh::Mesh mesh;
+	unified::reader::read(fn, mesh);
+	Counter cnt;
+	NoAttrs ac;
+	hry::writer::MeshHandle mh(mesh, seed);
+	cbm::encode<hry::writer::MeshHandle, Counter, NoAttrs, mesh::vtxidx_t, mesh::faceidx_t>(mh, cnt, ac, gate);
+
+	double t = bench::measure([&]() {
+		Counter c;
+		hry::writer::MeshHandle h(mesh, seed);
+		cbm::encode<hry::writer::MeshHandle, Counter, NoAttrs, mesh::vtxidx_t, mesh::faceidx_t>(h, c, ac, gate);
+		bench::keep(c);
+	});
+
+	uint64_t seeds = 0;
+	for (int i = cbm::IFIRST; i < cbm::EOM; ++i) seeds += cnt.iops[i];
+	std::printf("%-24s %-7s %-7s %9u %7lu %8lu %8lu %7lu %7lu %10lu %8.4f %9.1f\n", fn.substr(fn.find_last_of('/') + 1).c_str(), seed2str(seed), gate2str(gate), mesh.num_face(), seeds, cnt.ops[cbm::BORDER], cnt.ops[cbm::SPLIT], cnt.ops[cbm::UNION], cnt.ops[cbm::NM], cnt.dist, cnt.entropy() / mesh.num_face(), t * 1e3);
+}
+
+// The valence coder, if the mesh qualifies
+static void run_tg(const std::string &fn)
+{
+	mesh::Mesh mesh;
+	unified::reader::read(fn, mesh);
+	TGCounter cnt;
+	NoAttrs ac;
+	hry::writer::MeshHandle mh(mesh);
+	std::string name = fn.substr(fn.find_last_of('/') + 1);
+	if (!tg::encode<hry::writer::MeshHandle, TGCounter, NoAttrs, mesh::vtxidx_t, mesh::faceidx_t>(mh, cnt, ac)) {
+		std::printf("%-24s %9u   not an oriented manifold triangle mesh\n", name.c_str(), mesh.num_face());
+		return;
+	}
+
+	double t = bench::measure([&]() {
+		TGCounter c;
+		hry::writer::MeshHandle h(mesh);
+		tg::encode<hry::writer::MeshHandle, TGCounter, NoAttrs, mesh::vtxidx_t, mesh::faceidx_t>(h, c, ac);
+		bench::keep(c);
+	});
+
+	std::printf("%-24s %9u %7lu %8lu %7lu %7lu %7lu %7lu %7lu %10lu %8.4f %9.1f\n", name.c_str(), mesh.num_face(), cnt.seeds, cnt.ops[tg::ADD], cnt.ops[tg::DUMMY], cnt.ops[tg::FWD], cnt.ops[tg::BWD], cnt.ops[tg::SPLIT], cnt.ops[tg::MERGE], cnt.dist, cnt.entropy() / mesh.num_face(), t * 1e3);
+}
+
+int main(int argc, const char **argv)
+{
+	if (argc < 2) {
+		std::fprintf(stderr, "usage: %s mesh...\n", argv[0]);
+		return 1;
+	}
+	std::printf("%-24s %-7s %-7s %9s %7s %8s %8s %7s %7s %10s %8s %9s\n", "mesh", "seed", "gate", "faces", "seeds", "border", "split", "union", "nm", "offsets", "bits/f", "ms");
+	try {
+		for (int i = 1; i < argc; ++i) {
+			for (cbm::GATE gate : { cbm::GATE_FRONT, cbm::GATE_FULLER }) {
+				run(argv[i], hry::SEED_INDEX, gate);
+				run(argv[i], hry::SEED_BORDER, gate);
+			}
+		}
+		std::printf("\nvalence coder\n%-24s %9s %7s %8s %7s %7s %7s %7s %7s %10s %8s %9s\n", "mesh", "faces", "seeds", "add", "dummy", "fwd", "bwd", "split", "merge", "offsets", "bits/f", "ms");
+		for (int i = 1; i < argc; ++i) run_tg(argv[i]);
+	} catch (const std::exception &e) {
+		std::fprintf(stderr, "%s\n", e.what());
+		return 1;
+	}
+}
@@ -22,6 +22,12 @@ enum INITOP {
 };
 enum OP { BORDER, CONNBWD, SPLIT, UNION, NM, NEWVTX, CONNFWD, CLOSE, FIRST = BORDER, LAST = CONNFWD }; // close is meta operation; never transmitted
 
+// Choice of the gate when a new face starts, stored by the format since the decoder repeats it
+enum GATE {
+	GATE_FRONT, // the gate after the last one, i.e. the traversal fans around the front vertex
+	GATE_FULLER // the gate at the front or the back vertex, whichever has more coded faces
+};
+
 static const char* op2str(OP op)
 {
 	static const char *lut[] = { "_", "<", "\xE2\x88\x9E", "\xE2\x88\xAA", "~", "*", ">", "?" };
@@ -17,9 +17,10 @@
 
 #pragma once
 
-#include <deque>
-#include <list>
 #include <vector>
+#include <limits>
+#include <algorithm>
+#include <stdint.h>
 
 #include "base.h"
 
@@ -49,148 +50,166 @@ std::ostream &operator<<(std::ostream &os, const DataTpl<T, V> &d)
 template <typename T, typename V>
 struct CutBorder {
 	typedef DataTpl<T, V> Data;
-	typedef std::list<Data> Elements;
-	struct Part : Elements {
+	typedef uint32_t Node; // index of an element in the arena
+	typedef uint32_t PartId; // stable index of a part
+	static const uint32_t NIL = std::numeric_limits<uint32_t>::max();
+
+	// The elements of all parts live in one arena and are linked by their indices.
+	// Released elements are reused, so the cut-border does not allocate once the arena has grown to the largest border.
+	// Every element knows its part and its label: the labels within a part are consecutive (modulo 2^32) from the front to the back, so the position of an element is its label minus the label of the front.
+	// The elements of the same vertex are linked as well, so that a vertex is found without searching the border.
+	struct Element {
+		Data d;
+		Node prev, next;
+		Node vprev, vnext; // other elements of the same vertex
+		PartId part;
+		uint32_t label;
+	};
+	struct Part {
+		Node head, tail;
+		uint32_t size;
+		uint32_t base; // label of the front
+		uint32_t pos; // slot in the stack
 		bool isEdgeBegin;
-		Part() : isEdgeBegin(true)
+		Part() : head(NIL), tail(NIL), size(0), base(0), pos(0), isEdgeBegin(true)
 		{}
 
-		std::size_t num_edges()
+		std::size_t num_edges() const
 		{
-			return this->size() - (isEdgeBegin ? 0 : 1);
+			return size - (isEdgeBegin ? 0 : 1);
 		}
 	};
-	typedef std::deque<Part> Parts;
-	Parts parts;
+	std::vector<Element> elements;
+	Node freelist;
+	std::vector<Part> parts; // by id
+	// The parts are stacked in slots with the current part on top. A part merged by a union leaves a dead slot (NIL) behind instead of moving the parts above it, and live counts the parts per slot in a Fenwick tree to give the position of a part among the live ones.
+	std::vector<PartId> stack, freeparts;
+	std::vector<uint32_t> live;
+	uint32_t nparts;
 	Data *first, *second;
 
-	// acceleration structure for fast lookup if a vertex is currently on the cutboder
-	std::vector<unsigned char> vertices;
+	// first element of every vertex on the cut-border, or NIL
+	std::vector<Node> vertices;
 
-	CutBorder(V num_vtx = 0) : vertices(num_vtx, 0)
+	CutBorder(V num_vtx = 0) : freelist(NIL), nparts(0), vertices(num_vtx, NIL)
 	{}
 
 	Part &cur_part()
 	{
-		return parts.back();
+		return parts[stack.back()];
 	}
 
 	bool atEnd()
 	{
-		return parts.empty();
+		return stack.empty();
 	}
 
 	void traverseStep(Data &v0, Data &v1)
 	{
 		Part &part = cur_part();
-		v0 = part.back();
-		v1 = part.front();
+		v0 = back(part);
+		v1 = front(part);
 	}
 
-	const Data &left() // previous on cut-border
-	{
-		return *(++cur_part().rbegin());
-	}
-	const Data &right() // next on cut-border
+	// GATE_FULLER: turns the current part by one element if the back vertex has more coded faces than the front one, so that the next gates fan around the vertex that is closer to completion.
+	// Only a closed part can turn, since its back connects to its front.
+	void focus(const std::vector<uint16_t> &order)
 	{
-		return cur_part().front();
+		Part &part = cur_part();
+		if (!part.isEdgeBegin || order[back(part).idx] <= order[front(part).idx]) return;
+		Node n = part.tail;
+		part.tail = prev(n);
+		elements[part.tail].next = NIL;
+		elements[n].prev = NIL;
+		elements[n].next = part.head;
+		elements[part.head].prev = n;
+		part.head = n;
+		elements[n].label = --part.base;
 	}
 
-	void activate_vertex(V i)
+	const Data &left() // previous on cut-border
 	{
-		++vertices[i];
+		return data(prev(cur_part().tail));
 	}
-	void deactivate_vertex(V i)
+	const Data &right() // next on cut-border
 	{
-		--vertices[i];
+		return front(cur_part());
 	}
+
 	bool on_cut_border(V i)
 	{
-#ifdef HAVE_ASSERT
-		assert_ge(vertices[i], 0);
-#endif
-		return vertices[i] != 0;
+		return vertices[i] != NIL;
 	}
 
-	typename Elements::iterator get_element(int i, int p = 0)
+	Node get_element(int i, int p = 0)
 	{
-		Part &part = parts[parts.size() - 1 - p];
+		Part &part = parts[stack[find_slot(nparts - p)]];
 
-		if (i > 0)
-			return std::next(part.begin(), i - 1);
-		else
-			return std::prev(part.end(), -i + 1);
+		Node n;
+		if (i > 0) {
+			n = part.head;
+			while (--i > 0) n = next(n);
+		} else {
+			n = part.tail;
+			while (i++ < 0) n = prev(n);
+		}
+		return n;
 	}
-	typename Elements::iterator find_element(Data v, int &i, int &p)
+	// Finds the element of v that a search from both ends of the current part and then of the parts below would find first: i is its offset from the front (i > 0) or the back (i <= 0), p the number of parts above it.
+	// Only the elements of v are visited, usually one.
+	Node find_element(Data v, int &i, int &p)
 	{
-		// search vertex in both directions
-		typename Parts::reverse_iterator part = parts.rbegin();
-		typename Elements::reverse_iterator l = part->rbegin();
-		typename Elements::iterator r = part->begin();
-
-		i = 0; p = 0;
-		while (1) {
-			if (r->idx == v.idx) {
-				++i;
-				return r;
-			} else if (l->idx == v.idx) {
-				i = -i;
-				return std::prev(l.base());
-			}
-
-			if (std::prev(l.base()) == r || l.base() == r) {
-				++p;
-				++part;
-#ifdef HAVE_ASSERT
-				assert(part != parts.rend());
-#endif
-				r = part->begin();
-				l = part->rbegin();
-				i = 0;
-			} else {
-				++r; ++l;
-				++i;
+		Node best = NIL;
+		uint32_t bestp = 0, bestd = 0;
+		bool bestfront = false;
+		for (Node n = vertices[v.idx]; n != NIL; n = elements[n].vnext) {
+			const Part &part = parts[elements[n].part];
+			uint32_t np = nparts - live_below(part.pos + 1);
+			uint32_t a = elements[n].label - part.base, b = part.size - 1 - a;
+			uint32_t d = std::min(a, b);
+			bool front = a <= b;
+			if (best == NIL || np < bestp || (np == bestp && (d < bestd || (d == bestd && front && !bestfront)))) {
+				best = n;
+				bestp = np;
+				bestd = d;
+				bestfront = front;
 			}
 		}
+		p = bestp;
+		i = bestfront ? bestd + 1 : -int(bestd);
+		return best;
 	}
 
 	void initial(Data v0, Data v1, Data v2)
 	{
-		parts.emplace_back();
-		Part &part = cur_part();
-		part.push_back(v0); activate_vertex(v0.idx);
-		part.push_back(v1); activate_vertex(v1.idx);
-		part.push_back(v2); activate_vertex(v2.idx);
+		Part &part = parts[push_part()];
+		push_back(part, v0);
+		push_back(part, v1);
+		push_back(part, v2);
 	}
 
 	void newVertex(Data v)
 	{
 		Part &part = cur_part();
-		first = &part.back();
-		part.push_back(v); activate_vertex(v.idx);
-		second = &part.back();
+		push_back(part, v);
+		first = &data(prev(part.tail));
+		second = &back(part);
 	}
 	Data connectForward(OP &op)
 	{
 		Part &part = cur_part();
-		Data d = *(++part.begin());
+		Data d = data(next(part.head));
 		if (!part.isEdgeBegin) {
 			op = border();
 			return Data();
 		} else if (istri()) {
-			typename Elements::iterator it = part.begin();
-			deactivate_vertex((it++)->idx);
-			deactivate_vertex((it++)->idx);
-			deactivate_vertex((it++)->idx);
-
-			parts.pop_back();
+			pop_part();
 			op = CLOSE;
 		} else {
-			deactivate_vertex(part.front().idx);
-			part.pop_front();
+			pop_front(part);
 
 			op = CONNFWD;
-			first = &cur_part().back();
+			first = &back(cur_part());
 		}
 		return d;
 	}
@@ -199,19 +218,18 @@ struct CutBorder {
 		Part &part = cur_part();
 
 		// NOTE: border and close operations are always renamed to connect forward
-		deactivate_vertex(part.back().idx);
-		part.pop_back();
+		pop_back(part);
 
 		op = CONNBWD;
-		first = &part.back();
+		first = &back(part);
 
-		return part.back();
+		return back(part);
 	}
 
 	bool istri()
 	{
 		Part &part = cur_part();
-		return part.num_edges() == 3 && part.size() == 3;
+		return part.num_edges() == 3 && part.size == 3;
 	}
 
 	OP border()
@@ -219,26 +237,21 @@ struct CutBorder {
 		Part &part = cur_part();
 		if (part.num_edges() == 1) {
 #ifdef HAVE_ASSERT
-			assert_eq(part.size(), 2);
+			assert_eq(part.size, 2);
 #endif
-			typename Elements::iterator it = part.begin();
-			deactivate_vertex((it++)->idx);
-			deactivate_vertex((it++)->idx);
-			parts.pop_back();
+			pop_part();
 		} else {
-			Data endvtx = part.back();
+			Data endvtx = back(part);
 
 			bool rename = !part.isEdgeBegin;
 
-			deactivate_vertex(part.back().idx);
-			part.pop_back();
+			pop_back(part);
 
 			if (!part.isEdgeBegin) {
-				deactivate_vertex(part.front().idx);
-				part.pop_front();
+				pop_front(part);
 			}
 
-			part.push_front(endvtx); activate_vertex(endvtx.idx);
+			push_front(part, endvtx);
 			part.isEdgeBegin = false;
 
 			if (rename) return CONNFWD;
@@ -247,53 +260,117 @@ struct CutBorder {
 		return BORDER;
 	}
 
-	Data splitCutBorder(typename Elements::iterator it)
+	Data splitCutBorder(Node it)
 	{
-		Part &part = cur_part();
-		Data gate = part.back();
-		deactivate_vertex(gate.idx);
-		part.pop_back();
-
-		parts.emplace_back();
-		Part &newpart = cur_part();
-		newpart.splice(newpart.begin(), part, part.begin(), it);
-		part.push_back(gate); activate_vertex(gate.idx);
-		newpart.push_back(*it); activate_vertex(it->idx);
-		std::swap(part.isEdgeBegin, newpart.isEdgeBegin);
+		Data gate = back(cur_part());
+		pop_back(cur_part());
+
+		// the elements in front of it move to a new part on top; the smaller of both sides is relabeled
+		PartId oldid = stack.back(), newid = push_part();
+		Part &part = parts[oldid], &newpart = parts[newid];
+		uint32_t k = elements[it].label - part.base;
+		if (k != 0) {
+			newpart.head = part.head;
+			newpart.tail = prev(it);
+			newpart.size = k;
+			newpart.base = part.base;
+			elements[newpart.tail].next = NIL;
+			elements[it].prev = NIL;
+			part.head = it;
+			part.size -= k;
+			part.base += k;
+			if (k <= part.size) {
+				assign(newpart, newid);
+			} else {
+				// the suffix takes the new id and stays in the slot below
+				assign(part, newid);
+				std::swap(part, newpart);
+				stack[part.pos] = oldid;
+				stack[newpart.pos] = newid;
+				std::swap(oldid, newid);
+			}
+		}
+		Part &lower = parts[oldid], &upper = parts[newid];
+		Data d = data(it);
+		push_back(lower, gate);
+		push_back(upper, d);
+		std::swap(lower.isEdgeBegin, upper.isEdgeBegin);
 
-		second = &newpart.back();
-		first = &part.back();
+		second = &back(upper);
+		first = &back(lower);
 
-		return *it;
+		return d;
 	}
 	Data splitCutBorder(int i)
 	{
 		return splitCutBorder(get_element(i));
 	}
 
-	Data cutBorderUnion(typename Elements::iterator it, int p)
+	Data cutBorderUnion(Node it, int p)
 	{
 		Part &part = cur_part();
-		Data gate = part.back();
-		deactivate_vertex(gate.idx);
-		part.pop_back();
-
-		Part &otherpart = parts[parts.size() - 1 - p];
-		part.push_back(gate); activate_vertex(gate.idx);
-		first = &part.back();
-		part.splice(part.end(), otherpart, it, otherpart.end());
-		part.splice(part.end(), otherpart, otherpart.begin(), otherpart.end()); // it is now end
-		part.push_back(*it); activate_vertex(it->idx);
-		second = &part.back();
-
-		// move part to front
-		for (typename Parts::iterator it = parts.begin() + (parts.size() - 1 - p); it < parts.end() - 1; ++it) {
-			it->swap(it[1]);
-			std::swap(it->isEdgeBegin, it[1].isEdgeBegin);
+		Data gate = back(part);
+		pop_back(part);
+		push_back(part, gate);
+		Node gaten = part.tail;
+
+		PartId curid = stack.back(), otherid = elements[it].part;
+		Part &otherpart = parts[otherid];
+		Data d = data(it);
+
+		// the other part is appended starting at it, i.e. rotated; the smaller of both pieces is relabeled to keep the labels consecutive
+		if (it != otherpart.head) {
+			uint32_t k = elements[it].label - otherpart.base;
+			Node front = otherpart.head, back = elements[it].prev;
+			elements[otherpart.tail].next = otherpart.head;
+			elements[otherpart.head].prev = otherpart.tail;
+			elements[back].next = NIL;
+			elements[it].prev = NIL;
+			if (k <= otherpart.size - k) {
+				relabel(front, NIL, otherpart.base + otherpart.size);
+				otherpart.base += k;
+			} else {
+				otherpart.base -= otherpart.size - k;
+				relabel(it, front, otherpart.base);
+			}
+			otherpart.head = it;
+			otherpart.tail = back;
 		}
-		parts.pop_back();
 
-		return *it;
+		// then the smaller part is relabeled to continue the other one; the merged part keeps the top slot
+		if (part.size <= otherpart.size) {
+			relabel(part.head, NIL, otherpart.base - part.size, otherid);
+			elements[part.tail].next = otherpart.head;
+			elements[otherpart.head].prev = part.tail;
+			otherpart.head = part.head;
+			otherpart.base -= part.size;
+			otherpart.size += part.size;
+			otherpart.isEdgeBegin = part.isEdgeBegin;
+			std::swap(part.pos, otherpart.pos);
+			stack[part.pos] = curid;
+			stack[otherpart.pos] = otherid;
+			std::swap(curid, otherid);
+		} else {
+			relabel(otherpart.head, NIL, part.base + part.size, curid);
+			elements[part.tail].next = otherpart.head;
+			elements[otherpart.head].prev = part.tail;
+			part.tail = otherpart.tail;
+			part.size += otherpart.size;
+		}
+		Part &merged = parts[curid];
+		Part &removed = parts[otherid];
+		push_back(merged, d);
+		first = &data(gaten);
+		second = &back(merged);
+
+		// remove the other part, leaving its slot dead
+		stack[removed.pos] = NIL;
+		live_add(removed.pos, -1);
+		--nparts;
+		removed = Part();
+		freeparts.push_back(otherid);
+
+		return d;
 	}
 	Data cutBorderUnion(int i, int p)
 	{
@@ -303,9 +380,9 @@ struct CutBorder {
 	bool findAndUpdate(Data v, int &i, int &p, OP &op)
 	{
 		if (!on_cut_border(v.idx)) return false;
-		typename Elements::iterator it = find_element(v, i, p);
+		Node it = find_element(v, i, p);
 #ifdef HAVE_ASSERT
-		assert_eq(get_element(i, p)->idx, v.idx);
+		assert_eq(get_element(i, p), it);
 #endif
 
 		if (p > 0) {
@@ -316,9 +393,9 @@ struct CutBorder {
 #endif
 		} else {
 			Part &part = cur_part();
-			if (part.isEdgeBegin && (++part.begin())->idx == v.idx) {
+			if (part.isEdgeBegin && data(next(part.head)).idx == v.idx) {
 				connectForward(op);
-			} else if ((++part.rbegin())->idx == v.idx) {
+			} else if (data(prev(part.tail)).idx == v.idx) {
 				connectBackward(op);
 			} else {
 				op = SPLIT;
@@ -330,6 +407,192 @@ struct CutBorder {
 		}
 		return true;
 	}
+
+private:
+	Data &data(Node n)
+	{
+		return elements[n].d;
+	}
+	Node next(Node n) const
+	{
+		return elements[n].next;
+	}
+	Node prev(Node n) const
+	{
+		return elements[n].prev;
+	}
+	Data &front(Part &part)
+	{
+		return data(part.head);
+	}
+	Data &back(Part &part)
+	{
+		return data(part.tail);
+	}
+
+	// pushes a new, empty part onto the stack
+	PartId push_part()
+	{
+		PartId id;
+		if (freeparts.empty()) {
+			id = parts.size();
+			parts.emplace_back();
+		} else {
+			id = freeparts.back();
+			freeparts.pop_back();
+		}
+		parts[id].pos = stack.size();
+		stack.push_back(id);
+		live_push(1);
+		++nparts;
+		return id;
+	}
+	// removes the current part and its elements
+	void pop_part()
+	{
+		Part &part = cur_part();
+		while (part.head != NIL) pop_back(part);
+		part = Part();
+		freeparts.push_back(stack.back());
+		--nparts;
+
+		// dead slots below the top are dropped as well
+		do {
+			stack.pop_back();
+			live.pop_back();
+		} while (!stack.empty() && stack.back() == NIL);
+	}
+
+	// Fenwick tree over the slots, stored like in arith::AdaptiveStatisticsModule: live[i - 1] counts the slots (i - (i & -i), i]
+	void live_add(uint32_t slot, int d)
+	{
+		for (uint32_t i = slot + 1; i <= live.size(); i += i & -i) {
+			live[i - 1] += d;
+		}
+	}
+	// appends a slot; its node covers the nodes of the slots below it
+	void live_push(uint32_t v)
+	{
+		uint32_t n = live.size() + 1;
+		for (uint32_t i = n - 1; i > n - (n & -n); i -= i & -i) {
+			v += live[i - 1];
+		}
+		live.push_back(v);
+	}
+	// number of live parts in the slots before slot
+	uint32_t live_below(uint32_t slot) const
+	{
+		uint32_t c = 0;
+		for (uint32_t i = slot; i != 0; i -= i & -i) {
+			c += live[i - 1];
+		}
+		return c;
+	}
+	// slot of the k-th live part from the bottom (k >= 1)
+	uint32_t find_slot(uint32_t k) const
+	{
+		uint32_t n = live.size(), s = 0, mid = 1;
+		while (mid * 2 <= n) mid *= 2;
+		for (; mid > 0; mid >>= 1) {
+			if (s + mid <= n && live[s + mid - 1] < k) {
+				k -= live[s + mid - 1];
+				s += mid;
+			}
+		}
+		return s;
+	}
+
+	// assigns the part id to all elements of the part
+	void assign(Part &part, PartId id)
+	{
+		for (Node n = part.head; n != NIL; n = next(n)) {
+			elements[n].part = id;
+		}
+	}
+	// labels the elements from n up to end (exclusive) consecutively starting with label, optionally moving them to another part
+	void relabel(Node n, Node end, uint32_t label, PartId id = NIL)
+	{
+		for (; n != end; n = next(n)) {
+			elements[n].label = label++;
+			if (id != NIL) elements[n].part = id;
+		}
+	}
+
+	Node alloc(const Data &d, Part &part)
+	{
+		Node n = freelist;
+		if (n == NIL) {
+			n = elements.size();
+			elements.emplace_back();
+		} else {
+			freelist = elements[n].next;
+		}
+		Element &e = elements[n];
+		e.d = d;
+		e.part = &part - parts.data();
+
+		// link into the elements of the vertex
+		e.vprev = NIL;
+		e.vnext = vertices[d.idx];
+		if (e.vnext != NIL) elements[e.vnext].vprev = n;
+		vertices[d.idx] = n;
+		return n;
+	}
+	void release(Node n)
+	{
+		Element &e = elements[n];
+		if (e.vprev == NIL) vertices[e.d.idx] = e.vnext;
+		else elements[e.vprev].vnext = e.vnext;
+		if (e.vnext != NIL) elements[e.vnext].vprev = e.vprev;
+
+		e.next = freelist;
+		freelist = n;
+	}
+
+	void push_back(Part &part, const Data &d)
+	{
+		Node n = alloc(d, part);
+		elements[n].label = part.base + part.size;
+		elements[n].prev = part.tail;
+		elements[n].next = NIL;
+		if (part.tail == NIL) part.head = n;
+		else elements[part.tail].next = n;
+		part.tail = n;
+		++part.size;
+	}
+	void push_front(Part &part, const Data &d)
+	{
+		Node n = alloc(d, part);
+		elements[n].label = --part.base;
+		elements[n].prev = NIL;
+		elements[n].next = part.head;
+		if (part.head == NIL) part.tail = n;
+		else elements[part.head].prev = n;
+		part.head = n;
+		++part.size;
+	}
+	void pop_back(Part &part)
+	{
+		Node n = part.tail;
+		part.tail = prev(n);
+		if (part.tail == NIL) part.head = NIL;
+		else elements[part.tail].next = NIL;
+		release(n);
+		--part.size;
+	}
+	void pop_front(Part &part)
+	{
+		Node n = part.head;
+		part.head = next(n);
+		if (part.head == NIL) part.tail = NIL;
+		else elements[part.head].prev = NIL;
+		release(n);
+		++part.base;
+		--part.size;
+	}
 };
 
+template <typename T, typename V>
+const uint32_t CutBorder<T, V>::NIL;
+
 }
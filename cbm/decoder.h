@@ -25,7 +25,7 @@
 namespace cbm {
 
 template <typename M, typename R, typename A, typename V = int, typename F = int>
-void decode(M &mesh, R &rd, A &ac)
+void decode(M &mesh, R &rd, A &ac, GATE gatepolicy = GATE_FRONT)
 {
 	typedef CutBorder<CoderData<typename M::Edge>, V> CutBorder;
 	CutBorder cutBorder(mesh.num_vtx());
@@ -114,6 +114,7 @@ void decode(M &mesh, R &rd, A &ac)
 		if (curtri == ntri) ++f;
 
 		while (!cutBorder.atEnd()) {
+			if (gatepolicy == GATE_FULLER && curtri == ntri) cutBorder.focus(order);
 			cutBorder.traverseStep(v0, v1);
 			typename M::Edge gate = v0.a;
 			typename M::Edge gateprev = cutBorder.left().a;
@@ -52,7 +52,7 @@ struct Perm {
 };
 
 template <typename M, typename W, typename A, typename V = int, typename F = int>
-void encode(M &mesh, W &wr, A &ac)
+void encode(M &mesh, W &wr, A &ac, GATE gatepolicy = GATE_FRONT)
 {
 	typedef CutBorder<CoderData<typename M::Edge>, V> CutBorder;
 	CutBorder cutBorder(mesh.num_vtx());
@@ -131,6 +131,7 @@ void encode(M &mesh, W &wr, A &ac)
 		++curtri;
 
 		while (!cutBorder.atEnd()) {
+			if (gatepolicy == GATE_FULLER && curtri == ntri) cutBorder.focus(order);
 			cutBorder.traverseStep(v0, v1);
 			Data data_gate = v0;
 			typename M::Edge gate = v0.a;
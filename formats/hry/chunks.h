@@ -0,0 +1,383 @@
+/*
+ * Copyright (C) 2017, Max von Buelow
+ * TU Darmstadt - Graphics, Capture and Massively Parallel Computing
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+/*
+ * Splitting of a mesh into chunks of connected components that are coded independently, and merging of the decoded chunks.
+ * Components larger than a chunk are cut into regions; the vertices and edges shared with earlier chunks (the seam) are stored in the chunk table.
+ */
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <exception>
+#include <cstring>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+
+#include "structs/mesh.h"
+
+namespace hry {
+namespace chunks {
+
+static const uint32_t NIL = std::numeric_limits<uint32_t>::max();
+
+// A group of components or a region of one with its own mesh (renumbered vertices, faces and attributes) and its own coded stream
+struct Chunk {
+	mesh::Mesh mesh;
+	std::string stream;
+
+	// encoder: vertices and faces of the whole mesh, and the coding order (edge of each vertex, first edge of each face), which the decoder numbers by
+	std::vector<mesh::vtxidx_t> vtx;
+	std::vector<mesh::faceidx_t> faces;
+	std::vector<mesh::conn::fepair> vorder, forder;
+
+	// seam: vertices coded by an earlier chunk as (decoded index, index in the merged mesh), edges whose twin belongs to an earlier chunk as (decoded edge, edge in the merged mesh)
+	std::vector<std::pair<mesh::vtxidx_t, mesh::vtxidx_t>> seam_vtx;
+	std::vector<std::pair<mesh::conn::fepair, mesh::conn::fepair>> seam_edges;
+};
+typedef std::vector<std::unique_ptr<Chunk>> Chunks;
+
+// Runs f(0), ..., f(n - 1) on up to one thread per core; the first exception is rethrown
+template <typename F>
+void parallel_for(std::size_t n, F f)
+{
+	std::size_t nthreads = std::min<std::size_t>(n, std::max(1u, std::thread::hardware_concurrency()));
+	std::atomic<std::size_t> next(0);
+	std::exception_ptr error;
+	std::atomic_flag failed = ATOMIC_FLAG_INIT;
+	std::vector<std::thread> threads;
+	for (std::size_t t = 0; t < nthreads; ++t) {
+		threads.emplace_back([&] {
+			for (std::size_t i = next++; i < n; i = next++) {
+				try {
+					f(i);
+				} catch (...) {
+					if (!failed.test_and_set()) error = std::current_exception();
+				}
+			}
+		});
+	}
+	for (std::thread &t : threads) t.join();
+	if (error) std::rethrow_exception(error);
+}
+
+// Copies everything but the elements: regions, bindings, attribute formats and bounds, and the face sizes
+inline void copy_layout(mesh::Mesh &src, mesh::Mesh &dst)
+{
+	mesh::attr::Attrs &s = src.attrs, &d = dst.attrs;
+	d.num_bindings_face = s.num_bindings_face;
+	d.num_bindings_vtx = s.num_bindings_vtx;
+	d.num_bindings_corner = s.num_bindings_corner;
+	d.off_reg_facelist = s.off_reg_facelist;
+	d.off_reg_vtxlist = s.off_reg_vtxlist;
+	d.off_reg_cornerlist = s.off_reg_cornerlist;
+	d.bindings_reg_facelist = s.bindings_reg_facelist;
+	d.bindings_reg_vtxlist = s.bindings_reg_vtxlist;
+	d.bindings_reg_cornerlist = s.bindings_reg_cornerlist;
+	for (mesh::listidx_t l = 0; l < s.size(); ++l) {
+		mesh::attr::Target target = s[l].target;
+		d.emplace_back(s[l].fmt(), s[l].interps(), target);
+		if (s[l].bounds().bytes() != 0) std::memcpy(d[l].bounds().data(), s[l].bounds().data(), s[l].bounds().bytes());
+	}
+	dst.faces.have_edges = src.faces.have_edges;
+}
+
+// Cuts the faces into at most n chunks of similar face counts. The vertex-connected components are taken in the order of their first face; those up to a chunk's share stay whole (in face order), larger ones are cut into regions in breadth-first order over the edges.
+inline std::vector<std::vector<mesh::faceidx_t>> partition(mesh::Mesh &mesh, std::size_t n)
+{
+	// union-find over the vertices
+	std::vector<mesh::vtxidx_t> parent(mesh.num_vtx());
+	for (mesh::vtxidx_t v = 0; v < parent.size(); ++v) parent[v] = v;
+	auto find = [&parent] (mesh::vtxidx_t v) {
+		while (parent[v] != v) v = parent[v] = parent[parent[v]];
+		return v;
+	};
+	for (mesh::faceidx_t f = 0; f < mesh.num_face(); ++f) {
+		mesh::vtxidx_t r = find(mesh.conn.org(f, 0));
+		for (mesh::ledgeidx_t e = 1; e < mesh.conn.num_edges(f); ++e) {
+			mesh::vtxidx_t o = find(mesh.conn.org(f, e));
+			if (o != r) parent[o] = r;
+		}
+	}
+
+	// number the components by their first face and sort the faces by component
+	std::vector<uint32_t> comp(mesh.num_vtx(), NIL), start(1, 0);
+	std::vector<uint32_t> fcomp(mesh.num_face());
+	for (mesh::faceidx_t f = 0; f < mesh.num_face(); ++f) {
+		mesh::vtxidx_t r = find(mesh.conn.org(f, 0));
+		if (comp[r] == NIL) {
+			comp[r] = start.size() - 1;
+			start.push_back(0);
+		}
+		fcomp[f] = comp[r];
+		++start[comp[r] + 1];
+	}
+	for (uint32_t i = 1; i < start.size(); ++i) start[i] += start[i - 1];
+	std::vector<mesh::faceidx_t> sorted(mesh.num_face());
+	std::vector<uint32_t> pos(start.begin(), start.end() - 1);
+	for (mesh::faceidx_t f = 0; f < mesh.num_face(); ++f) sorted[pos[fcomp[f]]++] = f;
+
+	std::vector<std::vector<mesh::faceidx_t>> faces;
+	uint64_t total = mesh.num_face(), acc = 0;
+	// a new chunk once the current one holds its share, never leaving one empty
+	auto cut = [&] () {
+		if (faces.empty() || (!faces.back().empty() && acc >= total * faces.size() / n && faces.size() < n)) faces.emplace_back();
+	};
+	std::vector<bool> seen;
+	std::vector<mesh::faceidx_t> queue;
+	for (uint32_t i = 0; i + 1 < start.size(); ++i) {
+		cut();
+		if (start[i + 1] - start[i] <= total / n) {
+			faces.back().insert(faces.back().end(), sorted.begin() + start[i], sorted.begin() + start[i + 1]);
+			acc += start[i + 1] - start[i];
+			continue;
+		}
+
+		if (seen.empty()) seen.resize(mesh.num_face(), false);
+		for (uint32_t k = start[i]; k < start[i + 1]; ++k) {
+			if (seen[sorted[k]]) continue;
+			seen[sorted[k]] = true;
+			queue.assign(1, sorted[k]);
+			for (std::size_t h = 0; h < queue.size(); ++h) {
+				mesh::faceidx_t f = queue[h];
+				cut();
+				faces.back().push_back(f);
+				++acc;
+				for (mesh::ledgeidx_t e = 0; e < mesh.conn.num_edges(f); ++e) {
+					mesh::conn::fepair t = mesh.conn.twin(mesh::conn::fepair(f, e));
+					if (seen[t.f()]) continue;
+					seen[t.f()] = true;
+					queue.push_back(t.f());
+				}
+			}
+		}
+	}
+	return faces;
+}
+
+// Copies the faces of chunk c, their vertices (added to those already in chunk.vtx) and the referenced attributes into the mesh of the chunk; fchunk and fmap give the chunk of every face of src and its index there.
+// Edges whose twin belongs to another chunk become borders.
+inline void extract(mesh::Mesh &src, uint32_t c, const std::vector<uint32_t> &fchunk, const std::vector<mesh::faceidx_t> &fmap, Chunk &chunk)
+{
+	mesh::attr::Attrs &sa = src.attrs;
+	mesh::Mesh &dst = chunk.mesh;
+	const std::vector<mesh::faceidx_t> &faces = chunk.faces;
+	copy_layout(src, dst);
+	mesh::Builder builder(dst);
+
+	// the vertices in ascending order, found by binary search (a map over all vertices per chunk would not scale with the number of chunks)
+	std::vector<mesh::vtxidx_t> &verts = chunk.vtx;
+	mesh::edgeidx_t ne = 0;
+	for (mesh::faceidx_t f : faces) {
+		ne += src.conn.num_edges(f);
+		for (mesh::ledgeidx_t e = 0; e < src.conn.num_edges(f); ++e) {
+			verts.push_back(src.conn.org(f, e));
+		}
+	}
+	std::sort(verts.begin(), verts.end());
+	verts.erase(std::unique(verts.begin(), verts.end()), verts.end());
+	auto vmap = [&verts] (mesh::vtxidx_t v) {
+		return mesh::vtxidx_t(std::lower_bound(verts.begin(), verts.end(), v) - verts.begin());
+	};
+	builder.alloc_vtx(verts.size());
+	builder.alloc_face(faces.size(), ne);
+
+	// attributes in the order of their first reference
+	std::vector<std::vector<mesh::attridx_t>> amap(sa.size());
+	auto attr = [&] (mesh::listidx_t l, mesh::attridx_t idx) {
+		if (amap[l].empty()) amap[l].resize(sa[l].size(), NIL);
+		if (amap[l][idx] == NIL) {
+			amap[l][idx] = dst.attrs[l].size();
+			mixing::View d = dst.attrs[l].add();
+			if (sa[l].fmt().bytes() != 0) std::memcpy(d.data(), sa[l][idx].data(), sa[l].fmt().bytes());
+		}
+		return amap[l][idx];
+	};
+
+	for (mesh::faceidx_t i = 0; i < faces.size(); ++i) {
+		mesh::faceidx_t f = faces[i];
+		mesh::ledgeidx_t nfe = src.conn.num_edges(f);
+		dst.conn.add_face(nfe);
+		for (mesh::ledgeidx_t e = 0; e < nfe; ++e) {
+			mesh::conn::fepair t = src.conn.twin(mesh::conn::fepair(f, e));
+			dst.conn.set_org(i, e, vmap(src.conn.org(f, e)));
+			dst.conn.edges[dst.conn.edge(mesh::conn::fepair(i, e))].twin = fchunk[t.f()] == c ? mesh::conn::fepair(fmap[t.f()], t.e()) : mesh::conn::fepair(i, e);
+		}
+
+		mesh::regidx_t r = sa.face2reg(f);
+		builder.face_reg(i, r);
+		for (mesh::listidx_t a = 0; a < sa.num_bindings_face_reg(r); ++a) {
+			builder.bind_face_attr(i, a, attr(sa.binding_reg_facelist(r, a), sa.binding_face_attr(f, a)));
+		}
+		for (mesh::listidx_t a = 0; a < sa.num_bindings_corner_reg(r); ++a) {
+			for (mesh::ledgeidx_t e = 0; e < nfe; ++e) {
+				builder.bind_corner_attr(i, e, a, attr(sa.binding_reg_cornerlist(r, a), sa.binding_corner_attr(f, e, a)));
+			}
+		}
+	}
+	for (mesh::vtxidx_t i = 0; i < verts.size(); ++i) {
+		mesh::vtxidx_t v = verts[i];
+		mesh::regidx_t r = sa.vtx2reg(v);
+		builder.vtx_reg(i, r);
+		for (mesh::listidx_t a = 0; a < sa.num_bindings_vtx_reg(r); ++a) {
+			builder.bind_vtx_attr(i, a, attr(sa.binding_reg_vtxlist(r, a), sa.binding_vtx_attr(v, a)));
+		}
+	}
+}
+
+// Splits the mesh into chunks for n threads; returns no chunks if there would be only one
+inline Chunks split(mesh::Mesh &mesh, std::size_t n)
+{
+	Chunks chunks;
+	std::vector<std::vector<mesh::faceidx_t>> faces = partition(mesh, n);
+	faces.erase(std::remove_if(faces.begin(), faces.end(), [] (const std::vector<mesh::faceidx_t> &f) { return f.empty(); }), faces.end());
+	if (faces.size() < 2) return chunks;
+
+	std::vector<uint32_t> fchunk(mesh.num_face());
+	std::vector<mesh::faceidx_t> fmap(mesh.num_face());
+	for (uint32_t c = 0; c < faces.size(); ++c) {
+		for (mesh::faceidx_t i = 0; i < faces[c].size(); ++i) {
+			fchunk[faces[c][i]] = c;
+			fmap[faces[c][i]] = i;
+		}
+		chunks.emplace_back(new Chunk);
+		chunks.back()->faces = std::move(faces[c]);
+	}
+
+	// vertices of no face go to the last chunk, which keeps them like the single stream (uncoded, after the coded ones)
+	std::vector<bool> used(mesh.num_vtx(), false);
+	for (mesh::faceidx_t f = 0; f < mesh.num_face(); ++f) {
+		for (mesh::ledgeidx_t e = 0; e < mesh.conn.num_edges(f); ++e) used[mesh.conn.org(f, e)] = true;
+	}
+	for (mesh::vtxidx_t v = 0; v < mesh.num_vtx(); ++v) {
+		if (!used[v]) chunks.back()->vtx.push_back(v);
+	}
+	parallel_for(chunks.size(), [&] (std::size_t c) {
+		extract(mesh, c, fchunk, fmap, *chunks[c]);
+	});
+	return chunks;
+}
+
+// Finds the seams of the coded chunks: the decoder numbers the vertices and faces of a chunk in coding order and appends them to the merged mesh, skipping vertices of earlier chunks
+inline void seams(mesh::Mesh &mesh, Chunks &chunks)
+{
+	std::vector<mesh::vtxidx_t> gvtx(mesh.num_vtx(), NIL);
+	std::vector<mesh::faceidx_t> gface(mesh.num_face(), NIL);
+	std::vector<mesh::ledgeidx_t> grot(mesh.num_face(), 0); // edge of the original face that becomes the first edge
+	mesh::vtxidx_t nv = 0;
+	mesh::faceidx_t nf = 0;
+	for (std::unique_ptr<Chunk> &c : chunks) {
+		for (mesh::vtxidx_t i = 0; i < c->vorder.size(); ++i) {
+			mesh::vtxidx_t g = c->vtx[c->mesh.conn.org(c->vorder[i])];
+			if (gvtx[g] == NIL) gvtx[g] = nv++;
+			else c->seam_vtx.emplace_back(i, gvtx[g]);
+		}
+		for (mesh::faceidx_t j = 0; j < c->forder.size(); ++j) {
+			mesh::faceidx_t f = c->faces[c->forder[j].f()];
+			gface[f] = nf + j;
+			grot[f] = c->forder[j].e();
+		}
+		for (mesh::faceidx_t j = 0; j < c->forder.size(); ++j) {
+			mesh::faceidx_t f = c->faces[c->forder[j].f()];
+			mesh::ledgeidx_t ne = mesh.conn.num_edges(f);
+			for (mesh::ledgeidx_t e = 0; e < ne; ++e) {
+				mesh::conn::fepair t = mesh.conn.twin(mesh::conn::fepair(f, e));
+				if (gface[t.f()] >= nf) continue; // border, this chunk or a later one
+				mesh::ledgeidx_t nt = mesh.conn.num_edges(t.f());
+				c->seam_edges.emplace_back(mesh::conn::fepair(j, (e + ne - grot[f]) % ne), mesh::conn::fepair(gface[t.f()], (t.e() + nt - grot[t.f()]) % nt));
+			}
+		}
+		nf += c->forder.size();
+	}
+}
+
+// Prepares the mesh of a chunk for decoding: the layout of the whole mesh and the element counts of the chunk table
+inline void init(mesh::Mesh &proto, mesh::vtxidx_t nv, mesh::faceidx_t nf, mesh::edgeidx_t ne, const std::vector<mesh::attridx_t> &sizes, mesh::Mesh &dst)
+{
+	copy_layout(proto, dst);
+	mesh::Builder builder(dst);
+	builder.alloc_vtx(nv);
+	builder.alloc_face(nf, ne);
+	for (mesh::listidx_t l = 0; l < sizes.size(); ++l) {
+		builder.alloc_attr(l, sizes[l]);
+	}
+}
+
+// Offsets of the next chunk in the merged mesh
+struct Bases {
+	mesh::vtxidx_t v;
+	mesh::faceidx_t f;
+	std::vector<mesh::attridx_t> a;
+
+	Bases(mesh::listidx_t nlists) : v(0), f(0), a(nlists, 0)
+	{}
+};
+
+// Appends a decoded chunk to dst, whose vertices, faces and attributes have been allocated for all chunks
+inline void append(Chunk &chunk, Bases &base, mesh::Mesh &dst)
+{
+	mesh::Mesh &src = chunk.mesh;
+	mesh::attr::Attrs &sa = src.attrs, &da = dst.attrs;
+
+	// the seam vertices were added by earlier chunks, the others are appended
+	std::vector<mesh::vtxidx_t> vglob(src.num_vtx(), NIL);
+	for (const std::pair<mesh::vtxidx_t, mesh::vtxidx_t> &s : chunk.seam_vtx) {
+		if (s.first >= vglob.size() || s.second >= base.v) throw std::runtime_error("Invalid seam vertex");
+		vglob[s.first] = s.second;
+	}
+	for (mesh::vtxidx_t v = 0; v < src.num_vtx(); ++v) {
+		if (vglob[v] != NIL) continue;
+		mesh::vtxidx_t g = vglob[v] = base.v++;
+		if (g >= da.num_vtx()) throw std::runtime_error("Invalid seam vertex");
+		mesh::regidx_t r = sa.vtx2reg(v);
+		da.vtx_regs[g] = r;
+		for (mesh::listidx_t a = 0; a < sa.num_bindings_vtx_reg(r); ++a) {
+			da.binding_vtx_attr(g, a) = base.a[sa.binding_reg_vtxlist(r, a)] + sa.binding_vtx_attr(v, a);
+		}
+	}
+
+	for (mesh::faceidx_t f = 0; f < src.num_face(); ++f) {
+		mesh::ledgeidx_t nfe = src.conn.num_edges(f);
+		mesh::faceidx_t g = dst.conn.add_face(nfe);
+		for (mesh::ledgeidx_t e = 0; e < nfe; ++e) {
+			mesh::conn::fepair t = src.conn.twin(mesh::conn::fepair(f, e));
+			dst.conn.set_org(g, e, vglob[src.conn.org(f, e)]);
+			dst.conn.edges[dst.conn.edge(mesh::conn::fepair(g, e))].twin = mesh::conn::fepair(base.f + t.f(), t.e());
+		}
+
+		mesh::regidx_t r = sa.face2reg(f);
+		da.face_regs[g] = r;
+		for (mesh::listidx_t a = 0; a < sa.num_bindings_face_reg(r); ++a) {
+			da.binding_face_attr(g, a) = base.a[sa.binding_reg_facelist(r, a)] + sa.binding_face_attr(f, a);
+		}
+		for (mesh::listidx_t a = 0; a < sa.num_bindings_corner_reg(r); ++a) {
+			for (mesh::ledgeidx_t e = 0; e < nfe; ++e) {
+				da.binding_corner_attr(g, e, a) = base.a[sa.binding_reg_cornerlist(r, a)] + sa.binding_corner_attr(f, e, a);
+			}
+		}
+	}
+	for (const std::pair<mesh::conn::fepair, mesh::conn::fepair> &s : chunk.seam_edges) {
+		mesh::conn::fepair a(base.f + s.first.f(), s.first.e()), b = s.second;
+		if (s.first.f() >= src.num_face() || a.e() >= dst.conn.num_edges(a.f()) || b.f() >= base.f || b.e() >= dst.conn.num_edges(b.f())) throw std::runtime_error("Invalid seam edge");
+		dst.conn.fmerge(a, b);
+	}
+
+	for (mesh::listidx_t l = 0; l < sa.size(); ++l) {
+		if (sa[l].bytes() != 0) std::memcpy(da[l].data() + base.a[l] * da[l].fmt().bytes(), sa[l].data(), sa[l].bytes());
+		base.a[l] += sa[l].size();
+	}
+	base.f += src.num_face();
+}
+}
+}
@@ -13,6 +13,18 @@ namespace hry {
 
 // Format version
 static const int VER_MAJ = 0;
-static const int VER_MIN = 1;
+static const int VER_MIN = 19;
+
+// Entropy coder backends, stored in the header
+enum CoderType { RANGE, RANS, RANGE32 };
+
+// Models for the attribute residuals, stored in the header
+enum ResidualModel { RESIDUAL_BYTES, RESIDUAL_BINARY, RESIDUAL_CONTEXT };
+
+// Connectivity coders, stored in the header; ENGINE_AUTO is only an option of the writer
+enum Engine { ENGINE_CBM, ENGINE_TG, ENGINE_AUTO };
+
+// Seed face selection of the encoder, not stored
+enum Seed { SEED_INDEX, SEED_BORDER };
 
 }
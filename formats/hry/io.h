@@ -9,6 +9,8 @@
 
 #pragma once
 
+#include <algorithm>
+
 #include "models.h"
 #include "transform.h"
 #include "structs/mixing.h"
@@ -16,11 +18,14 @@
 namespace hry {
 namespace io {
 
+template <typename P>
 struct writer {
-	HryModels &models;
-	arith::Encoder<> &coder;
+	typedef typename P::Encoder Encoder;
+
+	HryModels<P> &models;
+	Encoder &coder;
 
-	writer(HryModels &_models, arith::Encoder<> &_coder) : models(_models), coder(_coder)
+	writer(HryModels<P> &_models, Encoder &_coder) : models(_models), coder(_coder)
 	{}
 
 	void order(int i)
@@ -86,25 +91,60 @@ struct writer {
 		numtri(ntri);
 	}
 
+	// Connectivity of the valence coder: initial() and end() as above
+	void valence(int d)
+	{
+		models.conn_valence.template encode<uint8_t>(coder, std::min(d, 255));
+		if (d >= 255) vertid(d - 255);
+	}
+	void addvertex(int d)
+	{
+		tgop(tg::ADD);
+		valence(d);
+	}
+	void adddummy(int d)
+	{
+		tgop(tg::DUMMY);
+		vertid(d);
+	}
+	void forward()
+	{
+		tgop(tg::FWD);
+	}
+	void backward()
+	{
+		tgop(tg::BWD);
+	}
+	void splitlist(int i)
+	{
+		tgop(tg::SPLIT);
+		elem(i);
+	}
+	void mergelist(int i, int p)
+	{
+		tgop(tg::MERGE);
+		elem(i); part(p);
+	}
+
 	// Attributes
 	void attr_data(mixing::View e, mesh::listidx_t l)
 	{
 		attr_type(DATA, l);
-		models.attr_data[l]->enc(coder, e);
+		models.data_model(l).enc(coder, e);
 	}
 	void attr_type(AttrType type, mesh::listidx_t l)
 	{
-		models.attr_type[l]->template encode<uint8_t>(coder, type);
+		models.type_model(l).template encode<uint8_t>(coder, type);
 	}
 	void attr_ghist(uint32_t idx, mesh::listidx_t l)
 	{
 		attr_type(HIST, l);
-		models.attr_ghist[l]->template encode<uint32_t>(coder, idx);
+		models.ghist_model(l).template encode<uint32_t>(coder, idx);
 	}
 	void attr_lhist(uint16_t idx, mesh::listidx_t l)
 	{
 		attr_type(LHIST, l);
-		models.attr_lhist[l]->template encode<uint16_t>(coder, idx);
+		models.lhist_model(l).template encode<uint16_t>(coder, idx);
 	}
 	void reg_face(mesh::regidx_t r)
 	{
@@ -146,6 +186,10 @@ private:
 	{
 		models.conn_op.encode(coder, op);
 	}
+	void tgop(tg::OP op)
+	{
+		models.conn_tgop.encode(coder, op);
+	}
 
 	void elem(int i)
 	{
@@ -165,11 +209,14 @@ private:
 	}
 };
 
+template <typename P>
 struct reader {
-	HryModels &models;
-	arith::Decoder<> &coder;
+	typedef typename P::Decoder Decoder;
 
-	reader(HryModels &_models, arith::Decoder<> &_coder) : models(_models), coder(_coder)
+	HryModels<P> &models;
+	Decoder &coder;
+
+	reader(HryModels<P> &_models, Decoder &_coder) : models(_models), coder(_coder)
 	{}
 
 	void order(int i)
@@ -202,23 +249,36 @@ struct reader {
 	{
 		return models.conn_numtri.template decode<uint16_t>(coder);
 	}
+	tg::OP tgop()
+	{
+		return models.conn_tgop.template decode<tg::OP>(coder);
+	}
+	uint32_t valence()
+	{
+		uint32_t d = models.conn_valence.template decode<uint8_t>(coder);
+		return d == 255 ? d + vertid() : d;
+	}
+	uint32_t dummy()
+	{
+		return vertid();
+	}
 
 	// Attributes
 	void attr_data(mixing::View e, mesh::listidx_t l)
 	{
-		models.attr_data[l]->dec(coder, e);
+		models.data_model(l).dec(coder, e);
 	}
 	AttrType attr_type(mesh::listidx_t l)
 	{
-		return (AttrType)models.attr_type[l]->template decode<uint8_t>(coder);
+		return (AttrType)models.type_model(l).template decode<uint8_t>(coder);
 	}
 	uint32_t attr_ghist(mesh::listidx_t l)
 	{
-		models.attr_ghist[l]->template decode<uint32_t>(coder);
+		return models.ghist_model(l).template decode<uint32_t>(coder);
 	}
 	uint16_t attr_lhist(mesh::listidx_t l)
 	{
-		models.attr_lhist[l]->template decode<uint16_t>(coder);
+		return models.lhist_model(l).template decode<uint16_t>(coder);
 	}
 	mesh::regidx_t reg_face()
 	{
@@ -10,19 +10,92 @@
 #pragma once
 
 #include <vector>
+#include <stdexcept>
 
 #include "arith/coder.h"
+#include "arith/rangecoder.h"
+#include "arith/rans.h"
 #include "arith/model.h"
+#include "arith/model_bin.h"
+#include "arith/adapt.h"
+#include "arith/bypass.h"
 #include "arith/stat_adaptive.h"
+#include "arith/stat_pow2.h"
+#include "arith/stat_twolevel.h"
+#include "arith/stat_small.h"
+#include "arith/stat_compact.h"
+#include "arith/stat_static.h"
+#include "arith/nullcoder.h"
 #include "cbm/base.h"
+#include "tg/base.h"
+#include "common.h"
 
 namespace hry {
 
 enum AttrType { DATA, HIST, LHIST };
 
-template <typename TF = uint64_t>
-struct CBMInitModel : arith::Model<TF> {
-	arith::AdaptiveStatisticsModule<> stat;
+// A profile bundles an entropy coder with the statistics modules that drive it: Stats for byte models and SmallStats for the Cut-Border Machine operations.
+// Adapt<A> is Stats adapting by the policy A (arith/adapt.h); the byte models select their policy per stream. Switch decides when the residual bytes are bypassed (arith/bypass.h).
+struct RangeProfile {
+	typedef arith::RangeEncoder<> Encoder;
+	typedef arith::RangeDecoder<> Decoder;
+	typedef arith::CompactStatisticsModule<> Stats; // 16 bit counters, about 560 bytes per byte model
+	template <typename A> using Adapt = arith::Adapted<Stats, A>;
+	template <int N> using SmallStats = arith::SmallStatisticsModule<uint64_t, uint32_t, uint32_t, N>;
+	typedef arith::BypassSwitch<> Switch;
+};
+struct Range32Profile {
+	typedef arith::RangeEncoder<uint32_t> Encoder;
+	typedef arith::RangeDecoder<uint32_t> Decoder;
+	typedef arith::CompactStatisticsModule<uint32_t> Stats; // totals stay below 2^15
+	template <typename A> using Adapt = arith::Adapted<Stats, A>;
+	template <int N> using SmallStats = arith::SmallStatisticsModule<uint32_t, uint32_t, uint32_t, N, 16>; // totals must not exceed 2^24
+	typedef arith::BypassSwitch<> Switch;
+};
+struct RansProfile {
+	typedef arith::RansEncoder<> Encoder;
+	typedef arith::RansDecoder<> Decoder;
+	typedef arith::Pow2StatisticsModule<uint32_t> Stats; // constant total of 2^16, decoding needs no division
+	template <typename A> using Adapt = arith::Adapted<Stats, A>;
+	template <int N> using SmallStats = arith::SmallStatisticsModule<uint32_t, uint32_t, uint32_t, N>;
+	typedef arith::BypassSwitch<> Switch;
+};
+// Semi-static variant of a profile: the byte models use fixed tables from the header, the Cut-Border Machine operations stay adaptive
+template <typename P>
+struct SemiStaticProfile : P {
+	typedef arith::StaticStatisticsModule<typename P::Stats::FreqType> Stats;
+	template <typename A> using Adapt = Stats; // never updated
+};
+// Variant of a profile that only counts the bits of the adaptive models (the decoder is never used)
+template <typename P>
+struct CostProfile : P {
+	typedef arith::CostEncoder<typename P::Stats::FreqType> Encoder;
+};
+// First pass of the semi-static mode: nothing is coded, the byte models only count their symbols (the decoder is never used)
+struct HistogramProfile {
+	typedef arith::NullEncoder<> Encoder;
+	typedef arith::RangeDecoder<> Decoder;
+	typedef arith::HistogramModule<> Stats;
+	template <typename A> using Adapt = Stats; // the histograms count every symbol once
+	typedef arith::NoBypass Switch;
+	template <int N> using SmallStats = arith::SmallStatisticsModule<uint64_t, uint32_t, uint32_t, N>;
+};
+
+// Adaptation policies of the byte models
+typedef arith::Adaptation<1> SteadyAdapt; // increments of 1, halving only at the limit of the statistics module
+typedef arith::Adaptation<16, 13> FastAdapt; // forgets after a few hundred symbols, for streams whose statistics drift over the mesh (residuals, indices)
+
+template <typename P, typename T, typename A = SteadyAdapt>
+using AdaptiveModel = arith::ModelMult<T, typename P::template Adapt<A>, typename P::Encoder, typename P::Decoder>;
+template <typename P, typename T, typename A = SteadyAdapt>
+using IntModel = arith::ModelInt<T, typename P::template Adapt<A>, typename P::Encoder, typename P::Decoder>;
+
+template <typename P>
+struct CBMInitModel : arith::Model<typename P::Encoder, typename P::Decoder> {
+	typedef typename P::Encoder E;
+	typedef typename P::Decoder D;
+
+	typename P::template SmallStats<16> stat;
 
 	CBMInitModel() : stat(cbm::ILAST + 1)
 	{
@@ -31,14 +104,14 @@ struct CBMInitModel : arith::Model<TF> {
 		}
 	}
 
-	void enc(arith::Encoder<TF> &coder, const unsigned char *s, int n)
+	void enc(E &coder, const unsigned char *s, int n)
 	{
 		// TODO correct cast for s
 		const cbm::INITOP *sc = (const cbm::INITOP*)s;
 		coder(this->stat, *sc);
 		this->stat.inc(*sc);
 	}
-	void dec(arith::Decoder<TF> &coder, unsigned char *s, int n)
+	void dec(D &coder, unsigned char *s, int n)
 	{
 		cbm::INITOP *sc = (cbm::INITOP*)s;
 		*sc = (cbm::INITOP)coder(this->stat);
@@ -46,9 +119,43 @@ struct CBMInitModel : arith::Model<TF> {
 	}
 };
 
-template <int MAXORDER, typename TF = uint64_t>
-struct CBMModel : arith::Model<TF> {
-	arith::AdaptiveStatisticsModule<> stat;
+// The explicit operations of the valence coder; ADD dominates, the others mostly occur at borders and handles
+template <typename P>
+struct TGOpModel : arith::Model<typename P::Encoder, typename P::Decoder> {
+	typedef typename P::Encoder E;
+	typedef typename P::Decoder D;
+
+	typename P::template SmallStats<8> stat;
+
+	TGOpModel() : stat(tg::LAST + 1)
+	{
+		for (int i = tg::FIRST; i <= tg::LAST; ++i) {
+			stat.init(i);
+		}
+	}
+
+	void enc(E &coder, const unsigned char *s, int n)
+	{
+		const tg::OP *sc = (const tg::OP*)s;
+		coder(this->stat, *sc);
+		this->stat.inc(*sc);
+	}
+	void dec(D &coder, unsigned char *s, int n)
+	{
+		tg::OP *sc = (tg::OP*)s;
+		*sc = (tg::OP)coder(this->stat);
+		this->stat.inc(*sc);
+	}
+};
+
+template <int MAXORDER, typename P>
+struct CBMModel : arith::Model<typename P::Encoder, typename P::Decoder> {
+	typedef typename P::Encoder E;
+	typedef typename P::Decoder D;
+	typedef typename P::template SmallStats<8> S;
+	typedef uint64_t TF;
+
+	S stat;
 	TF c;
 	TF c_newvtx_i[MAXORDER], c_connfwd_i[MAXORDER];
 	int o;
@@ -71,7 +178,7 @@ struct CBMModel : arith::Model<TF> {
 		o = _o;
 	}
 
-	void enc(arith::Encoder<TF> &coder, const unsigned char *s, int n)
+	void enc(E &coder, const unsigned char *s, int n)
 	{
 		const cbm::OP *sc = (const cbm::OP*)s;
 		this->set_orderfreqs();
@@ -79,7 +186,7 @@ struct CBMModel : arith::Model<TF> {
 		this->inc(*sc);
 	}
 
-	void dec(arith::Decoder<TF> &coder, unsigned char *s, int n)
+	void dec(D &coder, unsigned char *s, int n)
 	{
 		cbm::OP *sc = (cbm::OP*)s;
 		this->set_orderfreqs();
@@ -104,7 +211,7 @@ private:
 		return o < MAXORDER ? o : MAXORDER - 1;
 	}
 
-	void inc(arith::AdaptiveStatisticsModule<>::SymType s)
+	void inc(typename S::SymType s)
 	{
 		int i = order2idx(o);
 		if (s == cbm::NEWVTX) {
@@ -116,96 +223,426 @@ private:
 		} else {
 			stat.inc(s);
 		}
+		if (c > (S::FFULL >> 2)) halve(); // keep the frequencies set by set_orderfreqs within the range of the statistics module
 	}
+
+	void halve()
+	{
+		c = 0;
+		for (int i = 0; i < MAXORDER; ++i) {
+			c_newvtx_i[i] = (c_newvtx_i[i] + 1) >> 1;
+			c_connfwd_i[i] = (c_connfwd_i[i] + 1) >> 1;
+			c += c_newvtx_i[i] + c_connfwd_i[i] - 2;
+		}
+		c += 2;
+	}
+};
+
+// Heap memory of a statistics module besides its own size; only the modules with vectors have any
+template <typename S>
+static inline std::size_t stats_heap(const S &s)
+{
+	return 0;
+}
+template <typename TF, typename TS, typename TC, int BITS>
+static inline std::size_t stats_heap(const arith::Pow2StatisticsModule<TF, TS, TC, BITS> &s)
+{
+	return (s.C.capacity() + s.N.capacity()) * sizeof(TF);
+}
+template <typename S, typename A>
+static inline std::size_t stats_heap(const arith::Adapted<S, A> &s)
+{
+	return stats_heap(static_cast<const S&>(s));
+}
+template <typename TF, typename TS, typename TC>
+static inline std::size_t stats_heap(const arith::HistogramModule<TF, TS, TC> &s)
+{
+	return s.H.capacity() * sizeof(uint64_t);
+}
+
+template <typename T, typename S, typename E, typename D>
+static inline std::size_t model_bytes(const arith::ModelMult<T, S, E, D> &m)
+{
+	std::size_t bytes = sizeof(m);
+	for (const S &s : m.stats) bytes += stats_heap(s);
+	return bytes;
+}
+template <typename T, typename S, typename E, typename D>
+static inline std::size_t model_bytes(const arith::ModelInt<T, S, E, D> &m)
+{
+	return sizeof(m) + stats_heap(m.stat);
+}
+
+// Codes all components of one attribute element; one instance per attribute list, chosen by make_attr_model
+template <typename P>
+struct AttrModel {
+	typedef typename P::Encoder E;
+	typedef typename P::Decoder D;
+
+	virtual ~AttrModel()
+	{}
+
+	virtual void enc(E &coder, mixing::View v) = 0;
+	virtual void dec(D &coder, mixing::View v) = 0;
+
+	// appends the statistics modules, if any, in coding order
+	virtual void statistics(std::vector<typename P::Stats*> &out)
+	{}
+	// memory in bytes, including heap allocations
+	virtual std::size_t bytes() const = 0;
 };
 
-template <typename S, typename TF = uint64_t>
-struct ModelVector : std::vector<arith::Model<TF>*>
+// Every coded byte of an element has its own statistics and bypass switch; pos holds the position of the k-th coded byte within the element
+static inline void attr_positions(const mixing::Fmt &fmt, int *pos)
 {
-	const mixing::Fmt &fmt;
+	int k = 0;
+	for (int i = 0; i < fmt.size(); ++i) {
+		for (int j = 0; j < mixing::SIZES[fmt.stype(i)]; ++j) {
+			pos[k++] = fmt.offset(i) + j;
+		}
+	}
+}
+
+template <typename P, typename S>
+static inline void enc_byte(typename P::Encoder &coder, S &stat, typename P::Switch &sw, unsigned char s)
+{
+	if (sw.bypassed()) {
+		coder.bypass(s, 8);
+		sw.skipped();
+		return;
+	}
+	coder(stat, s);
+	sw.coded(stat.frequency(s), arith::count_total(stat));
+	stat.inc(s);
+}
+template <typename P, typename S>
+static inline unsigned char dec_byte(typename P::Decoder &coder, S &stat, typename P::Switch &sw)
+{
+	if (sw.bypassed()) {
+		sw.skipped();
+		return coder.bypass(8);
+	}
+	unsigned char s = coder(stat);
+	sw.coded(stat.frequency(s), arith::count_total(stat));
+	stat.inc(s);
+	return s;
+}
+
+template <typename P, typename S>
+static inline void attr_enc(typename P::Encoder &coder, S *stats, typename P::Switch *sw, const int *pos, int nb, const unsigned char *p)
+{
+	for (int k = 0; k < nb; ++k) {
+		enc_byte<P>(coder, stats[k], sw[k], p[pos[k]]);
+	}
+}
+template <typename P, typename S>
+static inline void attr_dec(typename P::Decoder &coder, S *stats, typename P::Switch *sw, const int *pos, int nb, unsigned char *p)
+{
+	for (int k = 0; k < nb; ++k) {
+		p[pos[k]] = dec_byte<P>(coder, stats[k], sw[k]);
+	}
+}
 
-	ModelVector(const mixing::Fmt &_fmt) : fmt(_fmt)
+// NB coded bytes per element: the statistics are stored inline and the loop has a fixed trip count, so the element is coded by one straight-line kernel
+template <typename P, int NB>
+struct FixedAttrModel : AttrModel<P> {
+	typedef typename P::Encoder E;
+	typedef typename P::Decoder D;
+
+	typename P::template Adapt<FastAdapt> stats[NB];
+	typename P::Switch sw[NB];
+	int pos[NB];
+
+	FixedAttrModel(const mixing::Fmt &fmt)
 	{
-		for (int i = 0; i < fmt.size(); ++i) {
-			arith::Model<TF> *model;
-			switch (fmt.stype(i)) {
-			case mixing::FLOAT:  model = new arith::ModelMult<uint32_t, S, TF>(); break;
-			case mixing::DOUBLE: model = new arith::ModelMult<uint64_t, S, TF>(); break;
-			case mixing::ULONG:  model = new arith::ModelMult<uint64_t, S, TF>(); break;
-			case mixing::LONG:   model = new arith::ModelMult<int64_t,  S, TF>(); break;
-			case mixing::UINT:   model = new arith::ModelMult<uint32_t, S, TF>(); break;
-			case mixing::INT:    model = new arith::ModelMult<int32_t,  S, TF>(); break;
-			case mixing::USHORT: model = new arith::ModelMult<int16_t,  S, TF>(); break;
-			case mixing::SHORT:  model = new arith::ModelMult<uint16_t, S, TF>(); break;
-			case mixing::UCHAR:  model = new arith::ModelMult<int8_t,   S, TF>(); break;
-			case mixing::CHAR:   model = new arith::ModelMult<uint8_t,  S, TF>(); break;
+		attr_positions(fmt, pos);
+		for (int k = 0; k < NB; ++k) {
+			for (int s = 0; s < 256; ++s) {
+				stats[k].init(s);
 			}
-			this->push_back(model);
 		}
 	}
 
-	ModelVector(const ModelVector<S, TF>&) = delete;
-	ModelVector<S, TF> &operator=(const ModelVector<S, TF>&) = delete;
+	void enc(E &coder, mixing::View v)
+	{
+		attr_enc<P>(coder, stats, sw, pos, NB, v.data());
+	}
+	void dec(D &coder, mixing::View v)
+	{
+		attr_dec<P>(coder, stats, sw, pos, NB, v.data());
+	}
+	void statistics(std::vector<typename P::Stats*> &out)
+	{
+		for (int k = 0; k < NB; ++k) out.push_back(&stats[k]);
+	}
+	std::size_t bytes() const
+	{
+		std::size_t bytes = sizeof(*this);
+		for (int k = 0; k < NB; ++k) bytes += stats_heap(stats[k]);
+		return bytes;
+	}
+};
+
+// Same for any other number of bytes
+template <typename P>
+struct ByteAttrModel : AttrModel<P> {
+	typedef typename P::Encoder E;
+	typedef typename P::Decoder D;
+
+	typename P::template Adapt<FastAdapt> *stats;
+	typename P::Switch *sw;
+	int *pos;
+	int nb;
 
-	~ModelVector()
+	ByteAttrModel(const mixing::Fmt &fmt) : nb(0)
 	{
 		for (int i = 0; i < fmt.size(); ++i) {
-			switch (fmt.stype(i)) {
-			case mixing::FLOAT:  delete (arith::ModelMult<uint32_t, S, TF>*)(*this)[i]; break;
-			case mixing::DOUBLE: delete (arith::ModelMult<uint64_t, S, TF>*)(*this)[i]; break;
-			case mixing::ULONG:  delete (arith::ModelMult<uint64_t, S, TF>*)(*this)[i]; break;
-			case mixing::LONG:   delete (arith::ModelMult<int64_t,  S, TF>*)(*this)[i]; break;
-			case mixing::UINT:   delete (arith::ModelMult<uint32_t, S, TF>*)(*this)[i]; break;
-			case mixing::INT:    delete (arith::ModelMult<int32_t,  S, TF>*)(*this)[i]; break;
-			case mixing::USHORT: delete (arith::ModelMult<int16_t,  S, TF>*)(*this)[i]; break;
-			case mixing::SHORT:  delete (arith::ModelMult<uint16_t, S, TF>*)(*this)[i]; break;
-			case mixing::UCHAR:  delete (arith::ModelMult<int8_t,   S, TF>*)(*this)[i]; break;
-			case mixing::CHAR:   delete (arith::ModelMult<uint8_t,  S, TF>*)(*this)[i]; break;
+			nb += mixing::SIZES[fmt.stype(i)];
+		}
+		stats = new typename P::template Adapt<FastAdapt>[nb];
+		sw = new typename P::Switch[nb];
+		pos = new int[nb];
+		attr_positions(fmt, pos);
+		for (int k = 0; k < nb; ++k) {
+			for (int s = 0; s < 256; ++s) {
+				stats[k].init(s);
 			}
 		}
 	}
 
-	void enc(arith::Encoder<TF> &coder, mixing::View v)
+	ByteAttrModel(const ByteAttrModel<P>&) = delete;
+	ByteAttrModel<P> &operator=(const ByteAttrModel<P>&) = delete;
+
+	~ByteAttrModel()
+	{
+		delete [] stats;
+		delete [] sw;
+		delete [] pos;
+	}
+
+	void enc(E &coder, mixing::View v)
+	{
+		attr_enc<P>(coder, stats, sw, pos, nb, v.data());
+	}
+	void dec(D &coder, mixing::View v)
+	{
+		attr_dec<P>(coder, stats, sw, pos, nb, v.data());
+	}
+	void statistics(std::vector<typename P::Stats*> &out)
+	{
+		for (int k = 0; k < nb; ++k) out.push_back(&stats[k]);
+	}
+	std::size_t bytes() const
+	{
+		std::size_t bytes = sizeof(*this) + nb * (sizeof(*stats) + sizeof(*sw) + sizeof(int));
+		for (int k = 0; k < nb; ++k) bytes += stats_heap(stats[k]);
+		return bytes;
+	}
+};
+
+// Order-1 alternative (RESIDUAL_CONTEXT): the bytes of every component are coded from the most to the least significant one, and every byte below the top one is coded in the context of the magnitude class (bit length, 0 to 8) of the byte above.
+// The folded residuals are small numbers, so the class of the byte above tells how random the byte below is.
+template <typename P>
+struct ContextAttrModel : AttrModel<P> {
+	typedef typename P::Encoder E;
+	typedef typename P::Decoder D;
+	typedef typename P::template Adapt<FastAdapt> S;
+
+	static const int NCLASS = 9;
+
+	S *stats;
+	typename P::Switch *sw;
+	int *pos, *base; // in coding order: the position of every byte and the index of its statistics, of the first context if the byte is below the top one
+	bool *top;
+	int nb, ns;
+
+	ContextAttrModel(const mixing::Fmt &fmt) : nb(0), ns(0)
 	{
 		for (int i = 0; i < fmt.size(); ++i) {
-			(*this)[i]->enc(coder, v.data(i), v.bytes(i));
+			int size = mixing::SIZES[fmt.stype(i)];
+			nb += size;
+			ns += 1 + (size - 1) * NCLASS;
+		}
+		stats = new S[ns];
+		sw = new typename P::Switch[ns];
+		pos = new int[nb];
+		base = new int[nb];
+		top = new bool[nb];
+
+		int k = 0, b = 0;
+		for (int i = 0; i < fmt.size(); ++i) {
+			int size = mixing::SIZES[fmt.stype(i)];
+			for (int j = size - 1; j >= 0; --j, ++k) {
+				pos[k] = fmt.offset(i) + j;
+				top[k] = j == size - 1;
+				base[k] = b;
+				b += top[k] ? 1 : NCLASS;
+			}
+		}
+		for (int k = 0; k < ns; ++k) {
+			for (int s = 0; s < 256; ++s) {
+				stats[k].init(s);
+			}
 		}
 	}
 
-	void dec(arith::Decoder<TF> &coder, mixing::View v)
+	ContextAttrModel(const ContextAttrModel<P>&) = delete;
+	ContextAttrModel<P> &operator=(const ContextAttrModel<P>&) = delete;
+
+	~ContextAttrModel()
 	{
-		for (int i = 0; i < fmt.size(); ++i) {
-			(*this)[i]->dec(coder, v.data(i), v.bytes(i));
+		delete [] stats;
+		delete [] sw;
+		delete [] pos;
+		delete [] base;
+		delete [] top;
+	}
+
+	void enc(E &coder, mixing::View v)
+	{
+		const unsigned char *p = v.data();
+		int ctx = 0;
+		for (int k = 0; k < nb; ++k) {
+			int i = base[k] + (top[k] ? 0 : ctx);
+			unsigned char s = p[pos[k]];
+			enc_byte<P>(coder, stats[i], sw[i], s);
+			ctx = magnitude(s);
 		}
 	}
+	void dec(D &coder, mixing::View v)
+	{
+		unsigned char *p = v.data();
+		int ctx = 0;
+		for (int k = 0; k < nb; ++k) {
+			int i = base[k] + (top[k] ? 0 : ctx);
+			unsigned char s = dec_byte<P>(coder, stats[i], sw[i]);
+			p[pos[k]] = s;
+			ctx = magnitude(s);
+		}
+	}
+	void statistics(std::vector<typename P::Stats*> &out)
+	{
+		for (int k = 0; k < ns; ++k) out.push_back(&stats[k]);
+	}
+	std::size_t bytes() const
+	{
+		std::size_t bytes = sizeof(*this) + ns * (sizeof(S) + sizeof(*sw)) + nb * (2 * sizeof(int) + sizeof(bool));
+		for (int k = 0; k < ns; ++k) bytes += stats_heap(stats[k]);
+		return bytes;
+	}
+
+private:
+	static int magnitude(unsigned char s)
+	{
+		return s == 0 ? 0 : 32 - __builtin_clz(s);
+	}
 };
 
-struct HryModels {
-	CBMModel<8> conn_op;
-	CBMInitModel<> conn_iop;
-	arith::ModelMult<uint32_t, arith::AdaptiveStatisticsModule<>> conn_elem;
-	arith::ModelMult<uint16_t, arith::AdaptiveStatisticsModule<>> conn_part;
-	arith::ModelMult<uint32_t, arith::AdaptiveStatisticsModule<>> conn_vert;
-	arith::ModelMult<uint16_t, arith::AdaptiveStatisticsModule<>> conn_numtri;
-	arith::ModelMult<uint16_t, arith::AdaptiveStatisticsModule<>> conn_regface, conn_regvtx;
-
-	std::vector<arith::ModelMult<uint8_t, arith::AdaptiveStatisticsModule<>>*> attr_type;
-	std::vector<arith::ModelMult<uint32_t, arith::AdaptiveStatisticsModule<>>*> attr_ghist;
-	std::vector<arith::ModelMult<uint16_t, arith::AdaptiveStatisticsModule<>>*> attr_lhist;
-	std::vector<ModelVector<arith::AdaptiveStatisticsModule<>>*> attr_data;
-
-	HryModels(mesh::Mesh &mesh) :
-		conn_numtri(false), conn_regface(false), conn_regvtx(false)
-	{
-		for (int i = 0; i < mesh.attrs.size(); ++i) {
-			attr_type.push_back(new arith::ModelMult<uint8_t, arith::AdaptiveStatisticsModule<>>(false));
-			attr_type.back()->init(DATA); attr_type.back()->init(HIST);
-			if (mesh.attrs[i].target == mesh::attr::CORNER) attr_type.back()->init(LHIST);
-			attr_ghist.push_back(new arith::ModelMult<uint32_t, arith::AdaptiveStatisticsModule<>>());
-			attr_lhist.push_back(new arith::ModelMult<uint16_t, arith::AdaptiveStatisticsModule<>>());
-			attr_data.push_back(new ModelVector<arith::AdaptiveStatisticsModule<>>(mesh.attrs[i].fmt()));
+// Binarized alternative (RESIDUAL_BINARY): every component is read as an unsigned integer (a folded residual) and coded by a BinaryInt with its own contexts, whose decisions use two-speed estimators
+template <typename P>
+struct BinaryAttrModel : AttrModel<P> {
+	typedef typename P::Encoder E;
+	typedef typename P::Decoder D;
+
+	struct Comp {
+		arith::BinaryInt<2, arith::MixBitModel<12, 3, 5>> model;
+		int offset, size;
+
+		Comp(int _offset, int _size) : model(_size * 8), offset(_offset), size(_size)
+		{}
+	};
+	std::vector<Comp> comps;
+
+	BinaryAttrModel(const mixing::Fmt &fmt)
+	{
+		comps.reserve(fmt.size());
+		for (int i = 0; i < fmt.size(); ++i) {
+			comps.emplace_back(fmt.offset(i), mixing::SIZES[fmt.stype(i)]);
 		}
+	}
 
+	void enc(E &coder, mixing::View v)
+	{
+		const unsigned char *p = v.data();
+		for (Comp &c : comps) {
+			uint64_t x = 0;
+			for (int j = 0; j < c.size; ++j) {
+				x |= uint64_t(p[c.offset + j]) << (8 * j);
+			}
+			c.model.enc(coder, x);
+		}
+	}
+	void dec(D &coder, mixing::View v)
+	{
+		unsigned char *p = v.data();
+		for (Comp &c : comps) {
+			uint64_t x = c.model.dec(coder);
+			for (int j = 0; j < c.size; ++j) {
+				p[c.offset + j] = x >> (8 * j);
+			}
+		}
+	}
+	std::size_t bytes() const
+	{
+		return sizeof(*this) + comps.capacity() * sizeof(Comp);
+	}
+};
+
+// The residual model from the header selects the format: binarized and order-1 context models code different streams.
+// Among the plain byte models, FixedAttrModel and ByteAttrModel code the same bytes in the same order with the same statistics, so only that choice does not affect the format
+template <typename P>
+AttrModel<P> *make_attr_model(const mixing::Fmt &fmt, ResidualModel rm)
+{
+	if (rm == RESIDUAL_BINARY) return new BinaryAttrModel<P>(fmt);
+	if (rm == RESIDUAL_CONTEXT) return new ContextAttrModel<P>(fmt);
+
+	int nb = 0;
+	for (int i = 0; i < fmt.size(); ++i) {
+		nb += mixing::SIZES[fmt.stype(i)];
+	}
+
+	switch (nb) {
+	case 3:  return new FixedAttrModel<P, 3>(fmt);  // uchar3 color
+	case 4:  return new FixedAttrModel<P, 4>(fmt);  // uchar4 color
+	case 6:  return new FixedAttrModel<P, 6>(fmt);  // quantized position or normal
+	case 8:  return new FixedAttrModel<P, 8>(fmt);  // float2 texture coordinate
+	case 12: return new FixedAttrModel<P, 12>(fmt); // float3 position or normal
+	case 15: return new FixedAttrModel<P, 15>(fmt); // float3 position, uchar3 color
+	case 16: return new FixedAttrModel<P, 16>(fmt); // float3 position, uchar4 color
+	case 24: return new FixedAttrModel<P, 24>(fmt); // float3 position and normal
+	case 27: return new FixedAttrModel<P, 27>(fmt); // float3 position and normal, uchar3 color
+	case 28: return new FixedAttrModel<P, 28>(fmt); // float3 position and normal, uchar4 color
+	default: return new ByteAttrModel<P>(fmt);
+	}
+}
+
+template <typename P>
+struct HryModels {
+	typedef typename P::Encoder Encoder;
+	typedef typename P::Decoder Decoder;
+
+	CBMModel<8, P> conn_op;
+	CBMInitModel<P> conn_iop;
+	IntModel<P, uint32_t, FastAdapt> conn_elem;
+	AdaptiveModel<P, uint16_t, FastAdapt> conn_part;
+	IntModel<P, uint32_t, FastAdapt> conn_vert;
+	AdaptiveModel<P, uint16_t, FastAdapt> conn_numtri;
+	AdaptiveModel<P, uint16_t, FastAdapt> conn_regface, conn_regvtx;
+	TGOpModel<P> conn_tgop;
+	AdaptiveModel<P, uint8_t, SteadyAdapt> conn_valence; // valences from 255 escape to conn_vert
+
+	// The models of the attribute lists are allocated on first use (see the accessors below), since many lists are never referenced or need only some of them
+	mesh::Mesh &mesh;
+	ResidualModel rm;
+	std::vector<AdaptiveModel<P, uint8_t, SteadyAdapt>*> attr_type;
+	std::vector<IntModel<P, uint32_t, SteadyAdapt>*> attr_ghist;
+	std::vector<AdaptiveModel<P, uint16_t, SteadyAdapt>*> attr_lhist;
+	std::vector<AttrModel<P>*> attr_data;
+
+	HryModels(mesh::Mesh &_mesh, ResidualModel _rm) :
+		conn_numtri(false), conn_regface(false), conn_regvtx(false), mesh(_mesh), rm(_rm),
+		attr_type(_mesh.attrs.size(), nullptr), attr_ghist(_mesh.attrs.size(), nullptr), attr_lhist(_mesh.attrs.size(), nullptr), attr_data(_mesh.attrs.size(), nullptr)
+	{
 		for (mesh::Faces::EdgeIterator it = mesh.faces.edge_begin(); it != mesh.faces.edge_end(); ++it) {
 			conn_numtri.init((uint16_t)(*it - 2));
 		}
@@ -234,6 +671,96 @@ struct HryModels {
 	{
 		conn_op.order(i);
 	}
+
+	AdaptiveModel<P, uint8_t, SteadyAdapt> &type_model(mesh::listidx_t l)
+	{
+		if (!attr_type[l]) {
+			attr_type[l] = new AdaptiveModel<P, uint8_t, SteadyAdapt>(false);
+			attr_type[l]->init(DATA); attr_type[l]->init(HIST);
+			if (is_corner(l)) attr_type[l]->init(LHIST);
+		}
+		return *attr_type[l];
+	}
+	IntModel<P, uint32_t, SteadyAdapt> &ghist_model(mesh::listidx_t l)
+	{
+		if (!attr_ghist[l]) attr_ghist[l] = new IntModel<P, uint32_t, SteadyAdapt>();
+		return *attr_ghist[l];
+	}
+	AdaptiveModel<P, uint16_t, SteadyAdapt> &lhist_model(mesh::listidx_t l) // only used by corner lists
+	{
+		if (!attr_lhist[l]) attr_lhist[l] = new AdaptiveModel<P, uint16_t, SteadyAdapt>();
+		return *attr_lhist[l];
+	}
+	AttrModel<P> &data_model(mesh::listidx_t l)
+	{
+		if (!attr_data[l]) attr_data[l] = make_attr_model<P>(mesh.attrs[l].fmt(), rm);
+		return *attr_data[l];
+	}
+
+	// All statistics modules of the byte models in a fixed order, which the semi-static tables in the header follow; this allocates all models a list can use
+	std::vector<typename P::Stats*> statistics()
+	{
+		std::vector<typename P::Stats*> out;
+		out.push_back(&conn_elem.stat);
+		for (auto &s : conn_part.stats) out.push_back(&s);
+		out.push_back(&conn_vert.stat);
+		for (auto &s : conn_numtri.stats) out.push_back(&s);
+		for (auto &s : conn_regface.stats) out.push_back(&s);
+		for (auto &s : conn_regvtx.stats) out.push_back(&s);
+		for (auto &s : conn_valence.stats) out.push_back(&s);
+		for (mesh::listidx_t l = 0; l < attr_data.size(); ++l) {
+			for (auto &s : type_model(l).stats) out.push_back(&s);
+			out.push_back(&ghist_model(l).stat);
+			if (is_corner(l)) {
+				for (auto &s : lhist_model(l).stats) out.push_back(&s);
+			}
+			data_model(l).statistics(out);
+		}
+		return out;
+	}
+
+	// Memory of all models allocated so far in bytes; count receives their number
+	std::size_t memory(int &count) const
+	{
+		std::size_t bytes = sizeof(*this) + model_bytes(conn_elem) + model_bytes(conn_part) + model_bytes(conn_vert) + model_bytes(conn_numtri) + model_bytes(conn_regface) + model_bytes(conn_regvtx) + model_bytes(conn_valence);
+		bytes -= sizeof(conn_elem) + sizeof(conn_part) + sizeof(conn_vert) + sizeof(conn_numtri) + sizeof(conn_regface) + sizeof(conn_regvtx) + sizeof(conn_valence); // already part of sizeof(*this)
+		count = 10;
+		for (int i = 0; i < attr_data.size(); ++i) {
+			if (attr_type[i]) { bytes += model_bytes(*attr_type[i]); ++count; }
+			if (attr_ghist[i]) { bytes += model_bytes(*attr_ghist[i]); ++count; }
+			if (attr_lhist[i]) { bytes += model_bytes(*attr_lhist[i]); ++count; }
+			if (attr_data[i]) { bytes += attr_data[i]->bytes(); ++count; }
+		}
+		bytes += (attr_type.capacity() + attr_ghist.capacity() + attr_lhist.capacity() + attr_data.capacity()) * sizeof(void*);
+		return bytes;
+	}
+
+private:
+	bool is_corner(mesh::listidx_t l) const
+	{
+		return mesh.attrs[l].target == mesh::attr::CORNER;
+	}
 };
 
+// Normalized frequency tables of the semi-static mode, one per statistics module in the order of HryModels::statistics()
+typedef std::vector<std::vector<uint32_t>> StaticTables;
+
+// The adaptive profiles have no tables
+template <typename P>
+void load_tables(HryModels<P> &models, const StaticTables &tables)
+{}
+template <typename P>
+void load_tables(HryModels<SemiStaticProfile<P>> &models, const StaticTables &tables)
+{
+	typedef typename SemiStaticProfile<P>::Stats S;
+	std::vector<S*> stats = models.statistics();
+	if (stats.size() != tables.size()) throw std::runtime_error("Semi-static tables do not match the models");
+	for (std::size_t i = 0; i < stats.size(); ++i) {
+		uint64_t sum = 0;
+		for (uint32_t f : tables[i]) sum += f;
+		if (tables[i].size() != stats[i]->n || (sum != 0 && sum != S::TOTAL)) throw std::runtime_error("Invalid semi-static table");
+		stats[i]->load(tables[i].data());
+	}
+}
+
 }
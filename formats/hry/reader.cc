@@ -8,13 +8,16 @@
  */
 
 #include <stdexcept>
+#include <algorithm>
 
 #include "reader.h"
 
 #include "common.h"
 #include "attrcode.h"
 #include "io.h"
+#include "chunks.h"
 #include "cbm/decoder.h"
+#include "tg/decoder.h"
 #include "utils/progress.h"
 
 namespace hry {
@@ -57,6 +60,14 @@ struct MeshHandle {
 
 struct HeaderReader {
 	std::istream &is;
+	CoderType coder;
+	ResidualModel residual;
+	bool semistatic;
+	cbm::GATE gate;
+	Engine engine;
+	StaticTables tables;
+	uint32_t nchunks;
+	chunks::Chunks chunks;
 
 	HeaderReader(std::istream &_is) : is(_is)
 	{}
@@ -75,6 +86,22 @@ struct HeaderReader {
 	void read_syntax(mesh::Builder &builder)
 	{
 		check_magic();
+		uint8_t c;
+		is.read((char*)&c, 1);
+		if (c > RANGE32) throw std::runtime_error("Unknown entropy coder");
+		coder = (CoderType)c;
+		is.read((char*)&c, 1);
+		if (c > RESIDUAL_CONTEXT) throw std::runtime_error("Unknown residual model");
+		residual = (ResidualModel)c;
+		is.read((char*)&c, 1);
+		semistatic = c != 0;
+		is.read((char*)&c, 1);
+		if (c > cbm::GATE_FULLER) throw std::runtime_error("Unknown gate policy");
+		gate = (cbm::GATE)c;
+		is.read((char*)&c, 1);
+		if (c > ENGINE_TG) throw std::runtime_error("Unknown connectivity coder");
+		engine = (Engine)c;
+		is.read((char*)&nchunks, 4);
 		uint32_t nvfe[3];
 		is.read((char*)nvfe, 3 * 4);
 
@@ -171,23 +198,154 @@ struct HeaderReader {
 			is.read((char*)&ntri, 2);
 			builder.seen_edge(ntri);
 		}
+
+		if (semistatic) read_tables();
+		if (nchunks != 0) read_chunks(builder.mesh, targets);
+	}
+
+	void read_tables()
+	{
+		uint32_t ntables;
+		is.read((char*)&ntables, 4);
+		for (uint32_t i = 0; i < ntables; ++i) {
+			uint16_t n;
+			is.read((char*)&n, 2);
+			std::vector<uint32_t> t(n, 0);
+			uint32_t nnz = read_varint(), s = 0;
+			for (uint32_t k = 0; k < nnz; ++k) {
+				s += read_varint();
+				if (s >= n) throw std::runtime_error("Invalid semi-static table");
+				t[s] = read_varint() + 1;
+			}
+			tables.push_back(std::move(t));
+		}
+	}
+
+	// Reads the chunk table with the seams and prepares the meshes of the chunks; their streams follow the header
+	void read_chunks(mesh::Mesh &mesh, const std::vector<mesh::attr::Target> &targets)
+	{
+		std::vector<uint64_t> len(nchunks);
+		for (uint32_t i = 0; i < nchunks; ++i) {
+			uint32_t nvfe[3];
+			is.read((char*)nvfe, 3 * 4);
+			std::vector<mesh::attridx_t> sizes(targets.size(), 0);
+			for (std::size_t l = 0; l < targets.size(); ++l) {
+				if (targets[l] != mesh::attr::NONE) is.read((char*)&sizes[l], 4);
+			}
+			is.read((char*)&len[i], 8);
+			if (!is) throw std::runtime_error("Unexpected end of file");
+			chunks.emplace_back(new chunks::Chunk);
+			chunks::Chunk &c = *chunks.back();
+			chunks::init(mesh, nvfe[0], nvfe[1], nvfe[2], sizes, c.mesh);
+
+			c.seam_vtx.resize(read_varint());
+			mesh::vtxidx_t v = 0, g = 0;
+			for (std::pair<mesh::vtxidx_t, mesh::vtxidx_t> &s : c.seam_vtx) {
+				v += read_varint();
+				g += read_svarint();
+				s = std::make_pair(v, g);
+			}
+			c.seam_edges.resize(read_varint());
+			mesh::faceidx_t f = 0, gf = 0;
+			for (std::pair<mesh::conn::fepair, mesh::conn::fepair> &s : c.seam_edges) {
+				f += read_varint();
+				mesh::ledgeidx_t e = read_varint();
+				gf += read_svarint();
+				s.first = mesh::conn::fepair(f, e);
+				s.second = mesh::conn::fepair(gf, read_varint());
+			}
+		}
+		// in pieces of at most 1 MiB, so that a corrupt length cannot allocate more than the file holds
+		for (uint32_t i = 0; i < nchunks; ++i) {
+			std::string &s = chunks[i]->stream;
+			for (uint64_t pos = 0; pos < len[i]; ) {
+				std::size_t n = std::min<uint64_t>(len[i] - pos, 1 << 20);
+				s.resize(pos + n);
+				is.read(&s[pos], n);
+				if (std::size_t(is.gcount()) != n) throw std::runtime_error("Unexpected end of file");
+				pos += n;
+			}
+		}
+	}
+
+private:
+	uint32_t read_varint()
+	{
+		uint32_t v = 0;
+		for (int shift = 0; shift < 32; shift += 7) {
+			int c = is.get();
+			if (c == EOF) throw std::runtime_error("Unexpected end of file");
+			v |= uint32_t(c & 0x7F) << shift;
+			if (!(c & 0x80)) break;
+		}
+		return v;
+	}
+	uint32_t read_svarint()
+	{
+		uint32_t z = read_varint();
+		return z >> 1 ^ -(z & 1);
 	}
 };
 
+template <typename P, typename PR = progress::handle>
+void decompress(typename P::Decoder &coder, mesh::Builder &builder, const HeaderReader &hr)
+{
+	HryModels<P> models(builder.mesh, hr.residual);
+	load_tables(models, hr.tables);
+	io::reader<P> rd(models, coder);
+	attrcode::AttrDecoder<io::reader<P>> ac(builder, rd);
+	MeshHandle meshhandle(builder.mesh);
+	if (hr.engine == ENGINE_TG) tg::decode<MeshHandle, io::reader<P>, attrcode::AttrDecoder<io::reader<P>>, mesh::vtxidx_t, mesh::faceidx_t>(meshhandle, rd, ac);
+	else cbm::decode<MeshHandle, io::reader<P>, attrcode::AttrDecoder<io::reader<P>>, mesh::vtxidx_t, mesh::faceidx_t>(meshhandle, rd, ac, hr.gate);
+	PR proga;
+	ac.decode(proga);
+}
+
+// Decodes either the single stream or the chunks in parallel, which are then appended to the mesh
+template <typename P>
+void read_coded(std::istream &is, mesh::Builder &builder, HeaderReader &hr)
+{
+	if (hr.chunks.empty()) {
+		typename P::Decoder coder(is);
+		decompress<P>(coder, builder, hr);
+		return;
+	}
+
+	// the chunk streams are decoded in place
+	chunks::parallel_for(hr.chunks.size(), [&] (std::size_t i) {
+		const std::string &s = hr.chunks[i]->stream;
+		typename P::Decoder coder((const unsigned char*)s.data(), s.size());
+		mesh::Builder cb(hr.chunks[i]->mesh);
+		decompress<P, progress::voidhandle>(coder, cb, hr);
+	});
+
+	chunks::Bases base(builder.mesh.attrs.size());
+	for (std::unique_ptr<chunks::Chunk> &c : hr.chunks) {
+		chunks::append(*c, base, builder.mesh);
+		c.reset();
+	}
+}
+
 void read(std::istream &is, mesh::Mesh &mesh)
 {
 	mesh::Builder builder(mesh);
 	HeaderReader hr(is);
 	hr.read_syntax(builder);
 
-	arith::Decoder<> coder(is);
-	HryModels models(builder.mesh);
-	io::reader rd(models, coder);
-	attrcode::AttrDecoder<io::reader> ac(builder, rd);
-	MeshHandle meshhandle(mesh);
-	cbm::decode<MeshHandle, io::reader, attrcode::AttrDecoder<io::reader>, mesh::vtxidx_t, mesh::faceidx_t>(meshhandle, rd, ac);
-	progress::handle proga;
-	ac.decode(proga);
+	switch (hr.coder) {
+	case RANGE:
+		if (hr.semistatic) read_coded<SemiStaticProfile<RangeProfile>>(is, builder, hr);
+		else read_coded<RangeProfile>(is, builder, hr);
+		break;
+	case RANGE32:
+		if (hr.semistatic) read_coded<SemiStaticProfile<Range32Profile>>(is, builder, hr);
+		else read_coded<Range32Profile>(is, builder, hr);
+		break;
+	case RANS:
+		if (hr.semistatic) read_coded<SemiStaticProfile<RansProfile>>(is, builder, hr);
+		else read_coded<RansProfile>(is, builder, hr);
+		break;
+	}
 }
 
 }
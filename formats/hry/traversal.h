@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2017, Max von Buelow
+ * TU Darmstadt - Graphics, Capture and Massively Parallel Computing
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+/*
+ * The mesh as seen by the Cut-Border Machine encoder: the remaining faces and the choice of the seed face that starts every traversal.
+ * The seed is not transmitted (the decoder reads the initial triangle), so the seed policy can change without changing the format.
+ */
+
+#pragma once
+
+#include <vector>
+#include <stdexcept>
+
+#include "common.h"
+#include "structs/mesh.h"
+
+namespace hry {
+namespace writer {
+
+struct MeshHandle {
+	typedef mesh::conn::fepair Edge;
+
+	mesh::Mesh &mesh;
+	Seed seed;
+	std::vector<bool> remaining;
+	mesh::faceidx_t num_remaining;
+	mesh::faceidx_t cursor; // no remaining face below
+	std::vector<Edge> borders; // SEED_BORDER: border edges in face order, one per face
+	std::size_t bcursor;
+
+	inline MeshHandle(mesh::Mesh &_mesh, Seed _seed = SEED_INDEX) : mesh(_mesh), seed(_seed), remaining(mesh.num_face(), true), num_remaining(mesh.num_face()), cursor(0), bcursor(0)
+	{
+		if (seed != SEED_BORDER) return;
+		for (mesh::faceidx_t f = 0; f < mesh.num_face(); ++f) {
+			for (mesh::ledgeidx_t e = 0; e < mesh.conn.num_edges(f); ++e) {
+				if (border(Edge(f, e))) {
+					borders.emplace_back(f, e);
+					break;
+				}
+			}
+		}
+	}
+
+	mesh::vtxidx_t num_vtx()
+	{
+		return mesh.num_vtx();
+	}
+	mesh::faceidx_t num_face()
+	{
+		return mesh.num_face();
+	}
+	Edge first(mesh::faceidx_t f)
+	{
+		return Edge(f, 0);
+	}
+
+	// SEED_INDEX: the remaining face with the lowest index.
+	// SEED_BORDER: the same, but faces at the border come first, oriented so that the border edge is the first gate; a traversal that starts at the border does not have to close around it later.
+	inline Edge choose_tri()
+	{
+		Edge a;
+		while (bcursor < borders.size() && !remaining[borders[bcursor].f()]) ++bcursor;
+		if (bcursor < borders.size()) {
+			a = next(borders[bcursor]);
+		} else {
+			while (cursor < remaining.size() && !remaining[cursor]) ++cursor;
+			if (cursor == remaining.size()) throw std::runtime_error("No face left to start a traversal");
+			a = Edge(cursor, 0);
+		}
+		remove(a.f());
+		return a;
+	}
+
+	inline Edge choose_twin(Edge i, bool &success)
+	{
+		mesh::conn::fepair a = mesh.conn.twin(i);
+		success = true;
+		if (a == i || !remaining[a.f()]) {
+			success = false;
+			return Edge();
+		}
+		remove(a.f());
+		return a;
+	}
+
+	inline bool empty()
+	{
+		return num_remaining == 0;
+	}
+
+	inline mesh::vtxidx_t org(Edge e)
+	{
+		return mesh.conn.org(e);
+	}
+	inline Edge next(Edge e)
+	{
+		return mesh.conn.enext(e);
+	}
+	inline Edge twin(Edge e)
+	{
+		return mesh.conn.twin(e);
+	}
+	inline void merge(Edge a, Edge b)
+	{
+		mesh.conn.fmerge(a, b);
+	}
+	inline void split(Edge e)
+	{
+		merge(e, e);
+	}
+	bool border(Edge e)
+	{
+		return twin(e) == e;
+	}
+
+	mesh::ledgeidx_t num_edges(mesh::faceidx_t f)
+	{
+		return mesh.conn.num_edges(f);
+	}
+	mesh::faceidx_t face(Edge e)
+	{
+		return mesh.conn.face(e);
+	}
+	mesh::ledgeidx_t edge(Edge e)
+	{
+		return e.e();
+	}
+
+private:
+	inline void remove(mesh::faceidx_t f)
+	{
+		remaining[f] = false;
+		--num_remaining;
+	}
+};
+
+}
+}
@@ -7,101 +7,28 @@
  * of the BSD 3-Clause license. See the LICENSE.txt file for details.
  */
 
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+#include <stdexcept>
+
 #include "writer.h"
 
 #include "common.h"
 #include "attrcode.h"
 #include "io.h"
+#include "chunks.h"
+#include "traversal.h"
 #include "cbm/encoder.h"
+#include "tg/encoder.h"
 #include "utils/progress.h"
 
 namespace hry {
 namespace writer {
 
-struct MeshHandle {
-	typedef mesh::conn::fepair Edge;
-
-	std::unordered_set<mesh::faceidx_t> remaining_faces;
-	mesh::Mesh &mesh;
-
-	inline MeshHandle(mesh::Mesh &_mesh) : mesh(_mesh)
-	{
-		for (mesh::faceidx_t i = 0; i < mesh.num_face(); ++i) {
-			remaining_faces.insert(i);
-		}
-	}
-
-	mesh::vtxidx_t num_vtx()
-	{
-		return mesh.num_vtx();
-	}
-
-	inline Edge choose_tri()
-	{
-		mesh::faceidx_t f = remaining_faces.find(0) == remaining_faces.end() ? *remaining_faces.begin() : 0;
-		Edge a = mesh::conn::fepair(f, 0);
-		remaining_faces.erase(f);
-		return a;
-	}
-
-	inline Edge choose_twin(Edge i, bool &success)
-	{
-		mesh::conn::fepair a = mesh.conn.twin(i);
-		success = true;
-		if (a == i || remaining_faces.find(a.f()) == remaining_faces.end()) {
-			success = false;
-			return Edge();
-		}
-		remaining_faces.erase(a.f());
-		return a;
-	}
-
-	inline bool empty()
-	{
-		return remaining_faces.empty();
-	}
-
-	inline mesh::vtxidx_t org(Edge e)
-	{
-		return mesh.conn.org(e);
-	}
-	inline Edge next(Edge e)
-	{
-		return mesh.conn.enext(e);
-	}
-	inline Edge twin(Edge e)
-	{
-		return mesh.conn.twin(e);
-	}
-	inline void merge(Edge a, Edge b)
-	{
-		mesh.conn.fmerge(a, b);
-	}
-	inline void split(Edge e)
-	{
-		merge(e, e);
-	}
-	bool border(Edge e)
-	{
-		return twin(e) == e;
-	}
-
-	mesh::ledgeidx_t num_edges(mesh::faceidx_t f)
-	{
-		return mesh.conn.num_edges(f);
-	}
-	mesh::faceidx_t face(Edge e)
-	{
-		return mesh.conn.face(e);
-	}
-	mesh::ledgeidx_t edge(Edge e)
-	{
-		return e.e();
-	}
-};
-
 struct HeaderWriter {
 	std::ostream &os;
+	std::vector<bool> seen_attrs;
 
 	HeaderWriter(std::ostream &_os) : os(_os)
 	{}
@@ -114,14 +41,43 @@ struct HeaderWriter {
 		os.write((char*)ver, 2);
 	}
 
-	void write_syntax(mesh::Mesh &mesh)
+	// Without chunks the counts are those of the mesh, otherwise the sums over the chunks (seam vertices counted once)
+	void write_syntax(mesh::Mesh &mesh, const Options &opts, const chunks::Chunks &chunks = chunks::Chunks())
 	{
 		write_magic();
+		uint8_t coder = opts.coder;
+		os.write((const char*)&coder, 1);
+		uint8_t residual = opts.residual;
+		os.write((const char*)&residual, 1);
+		uint8_t semistatic = opts.semistatic;
+		os.write((const char*)&semistatic, 1);
+		uint8_t gate = opts.gate;
+		os.write((const char*)&gate, 1);
+		uint8_t engine = opts.engine;
+		os.write((const char*)&engine, 1);
+		uint32_t nchunks = chunks.size();
+		os.write((const char*)&nchunks, 4);
 		uint32_t nvfe[] = { mesh.num_vtx(), mesh.num_face(), mesh.num_edge() };
+		std::vector<uint32_t> sizes(mesh.attrs.size());
+		for (std::size_t i = 0; i < sizes.size(); ++i) {
+			sizes[i] = mesh.attrs[i].size();
+		}
+		if (!chunks.empty()) {
+			std::fill(nvfe, nvfe + 3, 0);
+			std::fill(sizes.begin(), sizes.end(), 0);
+			for (const std::unique_ptr<chunks::Chunk> &c : chunks) {
+				nvfe[0] += c->mesh.num_vtx() - c->seam_vtx.size();
+				nvfe[1] += c->mesh.num_face();
+				nvfe[2] += c->mesh.num_edge();
+				for (std::size_t i = 0; i < sizes.size(); ++i) {
+					sizes[i] += c->mesh.attrs[i].size();
+				}
+			}
+		}
 		os.write((const char*)nvfe, 3 * 4);
 
 		// write reg bindings
-		std::vector<bool> seen_attrs(mesh.attrs.size(), false);
+		seen_attrs.assign(mesh.attrs.size(), false);
 
 		uint16_t nrfv[] = { mesh.attrs.num_regs_face(), mesh.attrs.num_regs_vtx() };
 		os.write((const char*)nrfv, 2 * 2);
@@ -152,8 +108,7 @@ struct HeaderWriter {
 		// write attribute meta
 		for (int i = 0; i < seen_attrs.size(); ++i) {
 			if (!seen_attrs[i]) continue;
-			uint32_t s = mesh.attrs[i].size();
-			os.write((char*)&s, 4);
+			os.write((char*)&sizes[i], 4);
 
 			const mixing::Fmt &fmt = mesh.attrs[i].fmt();
 			uint16_t nfmt = fmt.size();
@@ -194,27 +149,257 @@ struct HeaderWriter {
 		}
 	}
 
+	void write_tables(const StaticTables &tables)
+	{
+		// per table: number of symbols, number of nonzero frequencies, and (gap to the previous nonzero symbol, frequency - 1) pairs
+		uint32_t ntables = tables.size();
+		os.write((const char*)&ntables, 4);
+		for (const std::vector<uint32_t> &t : tables) {
+			uint16_t n = t.size();
+			os.write((const char*)&n, 2);
+			uint32_t nnz = 0;
+			for (uint32_t f : t) nnz += f != 0;
+			write_varint(nnz);
+			uint32_t last = 0;
+			for (uint32_t s = 0; s < n; ++s) {
+				if (t[s] == 0) continue;
+				write_varint(s - last);
+				write_varint(t[s] - 1);
+				last = s;
+			}
+		}
+	}
+
+	void write_chunks(chunks::Chunks &chunks)
+	{
+		// per chunk: vertex, face and edge count, the sizes of the referenced attribute lists, the length of the stream and the seam
+		for (const std::unique_ptr<chunks::Chunk> &c : chunks) {
+			uint32_t nvfe[] = { c->mesh.num_vtx(), c->mesh.num_face(), c->mesh.num_edge() };
+			os.write((const char*)nvfe, 3 * 4);
+			for (std::size_t i = 0; i < seen_attrs.size(); ++i) {
+				if (!seen_attrs[i]) continue;
+				uint32_t s = c->mesh.attrs[i].size();
+				os.write((const char*)&s, 4);
+			}
+			uint64_t len = c->stream.size();
+			os.write((const char*)&len, 8);
+
+			// seam vertices by ascending decoded index, seam edges by ascending decoded face; the indices in the merged mesh follow the seam and are coded as differences
+			write_varint(c->seam_vtx.size());
+			mesh::vtxidx_t last = 0, lastg = 0;
+			for (const std::pair<mesh::vtxidx_t, mesh::vtxidx_t> &v : c->seam_vtx) {
+				write_varint(v.first - last);
+				write_svarint(v.second - lastg);
+				last = v.first;
+				lastg = v.second;
+			}
+			write_varint(c->seam_edges.size());
+			mesh::faceidx_t lastf = 0, lastgf = 0;
+			for (const std::pair<mesh::conn::fepair, mesh::conn::fepair> &e : c->seam_edges) {
+				write_varint(e.first.f() - lastf);
+				write_varint(e.first.e());
+				write_svarint(e.second.f() - lastgf);
+				write_varint(e.second.e());
+				lastf = e.first.f();
+				lastgf = e.second.f();
+			}
+		}
+	}
+
+private:
+	void write_varint(uint32_t v)
+	{
+		while (v >= 0x80) {
+			os.put((char)(v | 0x80));
+			v >>= 7;
+		}
+		os.put((char)v);
+	}
+	// a difference of two indices, zigzag coded
+	void write_svarint(uint32_t d)
+	{
+		write_varint(d << 1 ^ -(d >> 31));
+	}
+
+};
+
+struct NullAttrs {
+	void vtx(mesh::faceidx_t, mesh::ledgeidx_t) {}
+	void face(mesh::faceidx_t, mesh::ledgeidx_t) {}
 };
 
-void compress(std::ostream &os, mesh::Mesh &mesh)
+// The bits of the connectivity of the mesh under the adaptive models of the default coder, without coding it; negative if the valence coder does not apply to the mesh
+double connectivity_cost(mesh::Mesh &mesh, const Options &opts, Engine engine)
 {
-	HeaderWriter hw(os);
-	hw.write_syntax(mesh);
-	os.flush();
-	arith::Encoder<> coder(os);
-	HryModels models(mesh);
-	io::writer wr(models, coder);
-	attrcode::AttrCoder<io::writer> ac(mesh, wr);
-	MeshHandle meshhandle(mesh);
-	cbm::encode<MeshHandle, io::writer, attrcode::AttrCoder<io::writer>, mesh::vtxidx_t, mesh::faceidx_t>(meshhandle, wr, ac);
-	progress::handle proga;
+	typedef CostProfile<RangeProfile> P;
+	typename P::Encoder coder;
+	HryModels<P> models(mesh, opts.residual);
+	io::writer<P> wr(models, coder);
+	NullAttrs ac;
+	MeshHandle mh(mesh, opts.seed);
+	if (engine != ENGINE_TG) cbm::encode<MeshHandle, io::writer<P>, NullAttrs, mesh::vtxidx_t, mesh::faceidx_t>(mh, wr, ac, opts.gate);
+	else if (!tg::encode<MeshHandle, io::writer<P>, NullAttrs, mesh::vtxidx_t, mesh::faceidx_t>(mh, wr, ac)) return -1;
+	return coder.bits;
+}
+
+// Sums connectivity_cost over the chunks, which are run in parallel; negative if the valence coder does not apply to one of them
+double connectivity_cost(mesh::Mesh &mesh, const chunks::Chunks &chunks, const Options &opts, Engine engine)
+{
+	if (chunks.empty()) return connectivity_cost(mesh, opts, engine);
+	std::vector<double> cost(chunks.size());
+	chunks::parallel_for(chunks.size(), [&] (std::size_t i) {
+		cost[i] = connectivity_cost(chunks[i]->mesh, opts, engine);
+	});
+	double sum = 0;
+	for (double c : cost) {
+		if (c < 0) return -1;
+		sum += c;
+	}
+	return sum;
+}
+
+// The coding order of the vertices and faces is kept in the chunk, if given
+template <typename P, typename PR = progress::handle>
+void encode(typename P::Encoder &coder, HryModels<P> &models, mesh::Mesh &mesh, const Options &opts, chunks::Chunk *chunk = nullptr)
+{
+	io::writer<P> wr(models, coder);
+	attrcode::AttrCoder<io::writer<P>> ac(mesh, wr);
+	MeshHandle meshhandle(mesh, opts.seed);
+	if (opts.engine == ENGINE_TG) {
+		// write() has checked that the mesh qualifies, the stream would be incomplete otherwise
+		if (!tg::encode<MeshHandle, io::writer<P>, attrcode::AttrCoder<io::writer<P>>, mesh::vtxidx_t, mesh::faceidx_t>(meshhandle, wr, ac)) throw std::runtime_error("The valence coder failed on a mesh it accepted before");
+	} else {
+		cbm::encode<MeshHandle, io::writer<P>, attrcode::AttrCoder<io::writer<P>>, mesh::vtxidx_t, mesh::faceidx_t>(meshhandle, wr, ac, opts.gate);
+	}
+	PR proga;
 	ac.encode(proga);
 	coder.flush();
+	if (chunk) {
+		chunk->vorder = std::move(ac.order);
+		chunk->forder = std::move(ac.order_f);
+	}
+}
+
+// Returns the memory of the models
+template <typename P, typename PR = progress::handle>
+std::size_t compress(std::ostream &os, mesh::Mesh &mesh, const Options &opts, const StaticTables &tables, int &count, chunks::Chunk *chunk = nullptr)
+{
+	typename P::Encoder coder(os);
+	HryModels<P> models(mesh, opts.residual);
+	load_tables(models, tables);
+	encode<P, PR>(coder, models, mesh, opts, chunk);
+	return models.memory(count);
+}
+
+// Codes the chunks in parallel, then writes the header, the chunk table with the seams and their streams
+template <typename P>
+void write_coded(std::ostream &os, mesh::Mesh &mesh, const Options &opts, const StaticTables &tables, chunks::Chunks &chunks)
+{
+	HeaderWriter hw(os);
+	std::size_t bytes = 0;
+	int count = 0;
+	if (chunks.empty()) {
+		hw.write_syntax(mesh, opts);
+		if (opts.semistatic) hw.write_tables(tables);
+		os.flush();
+		bytes = compress<P>(os, mesh, opts, tables, count);
+	} else {
+		std::vector<std::size_t> cbytes(chunks.size());
+		std::vector<int> ccount(chunks.size());
+		chunks::parallel_for(chunks.size(), [&] (std::size_t i) {
+			std::ostringstream ss;
+			cbytes[i] = compress<P, progress::voidhandle>(ss, chunks[i]->mesh, opts, tables, ccount[i], chunks[i].get());
+			chunks[i]->stream = ss.str();
+		});
+		chunks::seams(mesh, chunks);
+
+		hw.write_syntax(mesh, opts, chunks);
+		if (opts.semistatic) hw.write_tables(tables);
+		hw.write_chunks(chunks);
+		for (std::size_t i = 0; i < chunks.size(); ++i) {
+			os.write(chunks[i]->stream.data(), chunks[i]->stream.size());
+			bytes += cbytes[i];
+			count += ccount[i];
+		}
+	}
+
+	if (opts.model_memory) {
+		std::cout << "Model memory: " << bytes << " Bytes in " << count << " models" << std::endl;
+	}
+}
+
+// First pass of the semi-static mode: runs the whole encoder without coding anything and normalizes the histograms of all byte models to the tables of the semi-static profile P.
+// Chunks are counted in parallel and their histograms summed, since their symbols (e.g. vertex ids) differ from those of the whole mesh.
+template <typename P>
+StaticTables gather_tables(mesh::Mesh &mesh, const Options &opts, chunks::Chunks &chunks)
+{
+	std::vector<std::unique_ptr<HryModels<HistogramProfile>>> models;
+	if (chunks.empty()) {
+		arith::NullEncoder<> coder;
+		models.emplace_back(new HryModels<HistogramProfile>(mesh, opts.residual));
+		encode(coder, *models[0], mesh, opts);
+	} else {
+		models.resize(chunks.size());
+		chunks::parallel_for(chunks.size(), [&] (std::size_t i) {
+			arith::NullEncoder<> coder;
+			models[i].reset(new HryModels<HistogramProfile>(chunks[i]->mesh, opts.residual));
+			encode<HistogramProfile, progress::voidhandle>(coder, *models[i], chunks[i]->mesh, opts);
+		});
+	}
+
+	std::vector<HistogramProfile::Stats*> hists = models[0]->statistics();
+	for (std::size_t m = 1; m < models.size(); ++m) {
+		std::vector<HistogramProfile::Stats*> other = models[m]->statistics();
+		for (std::size_t i = 0; i < hists.size(); ++i) {
+			for (uint32_t s = 0; s < hists[i]->n; ++s) hists[i]->H[s] += other[i]->H[s];
+		}
+	}
+	StaticTables tables(hists.size());
+	for (std::size_t i = 0; i < hists.size(); ++i) {
+		tables[i].resize(hists[i]->n);
+		P::Stats::normalize(hists[i]->H.data(), hists[i]->n, tables[i].data());
+	}
+	return tables;
 }
 
-void write(std::ostream &os, mesh::Mesh &mesh)
+// The semi-static mode gathers the tables first, scaled for its variant of the profile P
+template <typename P>
+void write_profile(std::ostream &os, mesh::Mesh &mesh, const Options &opts, chunks::Chunks &chunks)
 {
-	compress(os, mesh);
+	if (opts.semistatic) {
+		typedef SemiStaticProfile<P> S;
+		write_coded<S>(os, mesh, opts, gather_tables<S>(mesh, opts, chunks), chunks);
+	} else {
+		write_coded<P>(os, mesh, opts, StaticTables(), chunks);
+	}
+}
+
+void write(std::ostream &os, mesh::Mesh &mesh, const Options &_opts)
+{
+	// components and regions of large components are coded in parallel
+	chunks::Chunks chunks;
+	if (_opts.threads > 1) chunks = chunks::split(mesh, _opts.threads);
+
+	Options opts = _opts;
+	if (opts.engine == ENGINE_TG) {
+		if (connectivity_cost(mesh, chunks, opts, ENGINE_TG) < 0) throw std::runtime_error("The valence coder needs an oriented manifold triangle mesh");
+	} else if (opts.engine == ENGINE_AUTO) {
+		// the valence coder only if it codes the connectivity in fewer bits
+		double tg = connectivity_cost(mesh, chunks, opts, ENGINE_TG);
+		opts.engine = tg >= 0 && tg < connectivity_cost(mesh, chunks, opts, ENGINE_CBM) ? ENGINE_TG : ENGINE_CBM;
+	}
+
+	switch (opts.coder) {
+	case RANGE:
+		write_profile<RangeProfile>(os, mesh, opts, chunks);
+		break;
+	case RANGE32:
+		write_profile<Range32Profile>(os, mesh, opts, chunks);
+		break;
+	case RANS:
+		write_profile<RansProfile>(os, mesh, opts, chunks);
+		break;
+	}
 }
 
 }
@@ -11,12 +11,28 @@
 
 #include <ostream>
 
+#include "common.h"
+#include "cbm/base.h"
 #include "structs/mesh.h"
 
 namespace hry {
 namespace writer {
 
-void write(std::ostream &os, mesh::Mesh &mesh);
+struct Options {
+	CoderType coder;
+	ResidualModel residual;
+	bool semistatic; // two passes, static frequency tables in the header
+	bool model_memory; // print the memory of the models
+	int threads; // more than one: groups of connected components are coded in parallel into separate streams
+	Seed seed; // where the traversals start
+	cbm::GATE gate; // which gate starts the next face
+	Engine engine; // ENGINE_AUTO: the valence coder if the mesh (every chunk) is an oriented manifold triangle mesh whose connectivity it codes in fewer bits, the Cut-Border Machine otherwise
+
+	Options() : coder(RANGE), residual(RESIDUAL_BYTES), semistatic(false), model_memory(false), threads(1), seed(SEED_INDEX), gate(cbm::GATE_FRONT), engine(ENGINE_CBM)
+	{}
+};
+
+void write(std::ostream &os, mesh::Mesh &mesh, const Options &opts = Options());
 
 }
 }
@@ -28,6 +28,17 @@ namespace unified {
 namespace writer {
 
 enum FileType { HRY, PLY, OBJ, UNKNOWN };
+
+struct Options {
+	bool ply_ascii;
+#ifdef WITH_HRY
+	hry::writer::Options hry;
+#endif
+
+	Options() : ply_ascii(false)
+	{}
+};
+
 FileType get_mesh_type(const std::string &fn)
 {
 	std::string ext(fn.end() - 4, fn.end());
@@ -43,7 +54,7 @@ FileType get_mesh_type(const std::string &fn)
 	throw std::runtime_error("Unknown file extension");
 }
 
-void write(std::ostream &os, const std::string &fn, mesh::Mesh &mesh, FileType type = UNKNOWN, bool ply_ascii = false)
+void write(std::ostream &os, const std::string &fn, mesh::Mesh &mesh, FileType type = UNKNOWN, const Options &opts = Options())
 {
 	std::string dir = fn.substr(0, fn.find_last_of("/\\"));
 	type = type == UNKNOWN ? get_mesh_type(fn) : type;
@@ -51,12 +62,12 @@ void write(std::ostream &os, const std::string &fn, mesh::Mesh &mesh, FileType t
 	{
 #ifdef WITH_HRY
 	case HRY:
-		hry::writer::write(os, mesh);
+		hry::writer::write(os, mesh, opts.hry);
 		break;
 #endif
 #ifdef WITH_PLY
 	case PLY:
-		ply::writer::write(os, mesh, ply_ascii);
+		ply::writer::write(os, mesh, opts.ply_ascii);
 		break;
 #endif
 #ifdef WITH_OBJ
@@ -68,10 +79,10 @@ void write(std::ostream &os, const std::string &fn, mesh::Mesh &mesh, FileType t
 		throw std::runtime_error("Currently unimplemented");
 	}
 }
-std::size_t write(const std::string &fn, mesh::Mesh &mesh, FileType type = UNKNOWN, bool ply_ascii = false)
+std::size_t write(const std::string &fn, mesh::Mesh &mesh, FileType type = UNKNOWN, const Options &opts = Options())
 {
 	std::ofstream os(fn, std::ofstream::binary);
-	write(os, fn, mesh, type, ply_ascii);
+	write(os, fn, mesh, type, opts);
 	os.flush();
 	return os.tellp();
 }
@@ -28,9 +28,9 @@ struct Args {
 	unified::writer::FileType fmt;
 	std::vector<Quant> quant;
 	bool clearquant;
-	bool ply_ascii;
+	unified::writer::Options opts;
 
-	Args(int argc, const char **argv) : fmt(unified::writer::UNKNOWN), ply_ascii(false), quant(false), clearquant(false)
+	Args(int argc, const char **argv) : fmt(unified::writer::UNKNOWN), quant(false), clearquant(false)
 	{
 		using namespace std::string_literals;
 		args::parser args(argc, argv, "Harry mesh compressor");
@@ -44,6 +44,16 @@ struct Args {
 #ifdef WITH_PLY
 		const int ARG_PAS = args.add_opt(     "ply-ascii",   "PLY writer: Use ASCII format");
 #endif
+#ifdef WITH_HRY
+		const int ARG_COD = args.add_opt(     "coder",       "HRY writer: Entropy coder (range, range32, rans)");
+		const int ARG_RES = args.add_opt(     "residual",    "HRY writer: Attribute residual model (bytes, binary, context)");
+		const int ARG_SST = args.add_opt(     "semi-static", "HRY writer: Two passes with static frequency tables, for faster decoding");
+		const int ARG_MEM = args.add_opt(     "model-memory", "HRY writer: Print the memory of the entropy coding models");
+		const int ARG_THR = args.add_opt(     "threads",     "HRY writer: Code groups of connected components (large ones cut into regions) in parallel on this many threads");
+		const int ARG_SEE = args.add_opt(     "seed",        "HRY writer: Seed faces of the traversal (index, border)");
+		const int ARG_GAT = args.add_opt(     "gate",        "HRY writer: Gate that starts the next face (front, fuller)");
+		const int ARG_ENG = args.add_opt(     "engine",      "HRY writer: Connectivity coder (cbm, valence, auto); auto takes the valence coder if it codes the connectivity in fewer bits");
+#endif
 
 		int cur_l, cur_a = -1;
 		for (int arg = args.next(); arg != args::parser::end; arg = args.next()) {
@@ -65,7 +75,17 @@ struct Args {
 			else if (arg == ARG_QUA) { quant.push_back(Quant{ cur_l, cur_a, args.val<int>() }); cur_a = -1; }
 			else if (arg == ARG_CQU) clearquant = true;
 #ifdef WITH_PLY
-			else if (arg == ARG_PAS) ply_ascii  = true;
+			else if (arg == ARG_PAS) opts.ply_ascii = true;
+#endif
+#ifdef WITH_HRY
+			else if (arg == ARG_COD) opts.hry.coder = args.map("range"s, hry::RANGE, "range32"s, hry::RANGE32, "rans"s, hry::RANS);
+			else if (arg == ARG_RES) opts.hry.residual = args.map("bytes"s, hry::RESIDUAL_BYTES, "binary"s, hry::RESIDUAL_BINARY, "context"s, hry::RESIDUAL_CONTEXT);
+			else if (arg == ARG_SST) opts.hry.semistatic = true;
+			else if (arg == ARG_MEM) opts.hry.model_memory = true;
+			else if (arg == ARG_THR) opts.hry.threads = args.val<int>();
+			else if (arg == ARG_SEE) opts.hry.seed = args.map("index"s, hry::SEED_INDEX, "border"s, hry::SEED_BORDER);
+			else if (arg == ARG_GAT) opts.hry.gate = args.map("front"s, cbm::GATE_FRONT, "fuller"s, cbm::GATE_FULLER);
+			else if (arg == ARG_ENG) opts.hry.engine = args.map("auto"s, hry::ENGINE_AUTO, "cbm"s, hry::ENGINE_CBM, "valence"s, hry::ENGINE_TG);
 #endif
 		}
 	}
@@ -111,7 +131,7 @@ int main(int argc, const char **argv)
 	if (!args.quant.empty() || args.clearquant) std::cout << "Quantization took " << std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count() << " ms." << std::endl;
 
 	std::cout << "Writing output..." << std::endl;
-	std::size_t outbytes = unified::writer::write(args.out, mesh, args.fmt, args.ply_ascii);
+	std::size_t outbytes = unified::writer::write(args.out, mesh, args.fmt, args.opts);
 
 	std::chrono::high_resolution_clock::time_point t3 = std::chrono::high_resolution_clock::now();
 	std::cout << "Writing output took " << std::chrono::duration_cast<std::chrono::milliseconds>(t3 - t2).count() << " ms." << std::endl;
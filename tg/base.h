@@ -0,0 +1,334 @@
+/*
+ * Copyright (C) 2017, Max von Buelow
+ * TU Darmstadt - Graphics, Capture and Massively Parallel Computing
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+/*
+ * Valence-driven connectivity coding of oriented manifold triangle meshes.
+ *
+ * Related publications:
+ * Touma, Costa, and Craig Gotsman. "Triangle mesh compression." Proceedings of Graphics Interface. 1998.
+ * Alliez, Pierre, and Mathieu Desbrun. "Valence-driven connectivity encoding for 3D meshes." Computer Graphics Forum. Vol. 20. No. 3. 2001.
+ */
+
+#pragma once
+
+#include <vector>
+#include <limits>
+#include <stdint.h>
+
+namespace tg {
+
+// Operations for the triangle at the gate (focus, next): its third vertex is new (ADD, DUMMY for the vertex that closes a border loop), the one after next (FWD), the one before the focus (BWD), elsewhere on the current list (SPLIT) or on another list (MERGE).
+// FWD and BWD are only transmitted if the free edges of the vertices do not imply them.
+enum OP { ADD, DUMMY, FWD, BWD, SPLIT, MERGE, FIRST = ADD, LAST = MERGE };
+
+// The borders of the conquered region: cyclic lists of vertices, the current one on top of a stack.
+// Every element stores the border edge to its successor as handle H, the half-edge of the conquered triangle; vertices can occur several times after splits and merges.
+template <typename V, typename H>
+struct ActiveLists {
+	typedef uint32_t Node;
+	typedef uint32_t ListId;
+	static const uint32_t NIL = std::numeric_limits<uint32_t>::max();
+
+	struct Element {
+		V v;
+		H h;
+		Node prev, next;
+		Node vprev, vnext; // other elements of the same vertex
+		ListId list;
+	};
+	struct List {
+		Node focus;
+		uint32_t size;
+	};
+	std::vector<Element> elements;
+	Node freelist;
+	std::vector<List> lists; // by id
+	std::vector<ListId> stack, freeids;
+
+	// per vertex: first element, or NIL, and the number of edges that are not conquered yet
+	std::vector<Node> vertices;
+	std::vector<int> freec;
+
+	ActiveLists(V num_vtx = 0) : freelist(NIL), vertices(num_vtx, NIL), freec(num_vtx, 0)
+	{}
+
+	void reserve(V num_vtx)
+	{
+		vertices.reserve(num_vtx);
+		freec.reserve(num_vtx);
+	}
+	void add_vertex(V v, int degree)
+	{
+		if (v >= vertices.size()) {
+			vertices.resize(v + 1, NIL);
+			freec.resize(v + 1, 0);
+		}
+		freec[v] = degree;
+	}
+
+	bool empty() const
+	{
+		return stack.empty();
+	}
+	const List &cur() const
+	{
+		return lists[stack.back()];
+	}
+	Node focus() const
+	{
+		return cur().focus;
+	}
+	Node next(Node n) const
+	{
+		return elements[n].next;
+	}
+	Node prev(Node n) const
+	{
+		return elements[n].prev;
+	}
+	V vtx(Node n) const
+	{
+		return elements[n].v;
+	}
+	const H &handle(Node n) const
+	{
+		return elements[n].h;
+	}
+	ListId list(Node n) const
+	{
+		return elements[n].list;
+	}
+
+	// the element off steps after n (before, if negative)
+	Node walk(Node n, int off) const
+	{
+		for (; off > 0; --off) n = next(n);
+		for (; off < 0; ++off) n = prev(n);
+		return n;
+	}
+	// the shorter way from n to x in steps, positive forwards
+	int offset(Node n, Node x) const
+	{
+		Node a = n, b = n;
+		for (int k = 0; ; ++k) {
+			if (a == x) return k;
+			if (b == x) return -k;
+			a = next(a);
+			b = prev(b);
+		}
+	}
+
+	// a new list of one triangle, focused on a
+	void start(V a, H ha, V b, H hb, V c, H hc)
+	{
+		ListId id = new_list();
+		stack.push_back(id);
+		Node na = alloc(a, ha, id), nb = alloc(b, hb, id), nc = alloc(c, hc, id);
+		link(na, nb); link(nb, nc); link(nc, na);
+		lists[id].focus = na;
+		lists[id].size = 3;
+		freec[a] -= 2; freec[b] -= 2; freec[c] -= 2;
+	}
+
+	// the triangle (next, focus, prev); the border edge from prev to next is new and the focus leaves (see refocus)
+	void backward(H hpn)
+	{
+		List &l = lists[stack.back()];
+		if (l.size == 3) return close();
+		Node f = l.focus, p = prev(f), n = next(f);
+		link(p, n);
+		release(f);
+		elements[p].h = hpn;
+		--freec[vtx(p)]; --freec[vtx(n)];
+		--l.size;
+		l.focus = refocus(p, n);
+	}
+	// the triangle (next, focus, next of next); the border edge from the focus to the next of next is new and next leaves
+	void forward(H hfm)
+	{
+		List &l = lists[stack.back()];
+		if (l.size == 3) return close();
+		Node f = l.focus, n = next(f), m = next(n);
+		link(f, m);
+		release(n);
+		elements[f].h = hfm;
+		--freec[vtx(f)]; --freec[vtx(m)];
+		--l.size;
+	}
+	// the triangle (next, focus, w) with a new vertex w, which is inserted after the focus
+	void add(V w, H hfw, H hwn)
+	{
+		ListId id = stack.back();
+		Node f = lists[id].focus, n = next(f);
+		Node x = alloc(w, hwn, id);
+		link(f, x); link(x, n);
+		elements[f].h = hfw;
+		--freec[vtx(f)]; --freec[vtx(n)]; freec[w] -= 2;
+		++lists[id].size;
+	}
+	// the triangle (next, focus, x) with x off steps from the focus on the current list: the elements from next up to x exclusive and a copy of x form a new list below the current one, focused on the copy so that it continues along the old border
+	void split(Node x, int off, H hfw, H hwn)
+	{
+		ListId id = stack.back(), nid = new_list();
+		Node f = lists[id].focus, n = next(f), xp = prev(x);
+		uint32_t size = lists[id].size, k = off > 0 ? off : size + off; // the new list has k elements, the current one keeps size - k + 1
+		V w = vtx(x);
+		Node y = alloc(w, hwn, id);
+		link(xp, y); link(y, n); link(f, x);
+		elements[f].h = hfw;
+		--freec[vtx(f)]; --freec[vtx(n)]; freec[w] -= 2;
+
+		// the smaller list takes the new id
+		if (k <= size - k + 1) {
+			relabel(n, y, nid);
+			lists[nid].focus = y;
+			lists[nid].size = k;
+			lists[id].size = size - k + 1;
+			stack.insert(stack.end() - 1, nid);
+		} else {
+			relabel(x, f, nid);
+			lists[nid].focus = f;
+			lists[nid].size = size - k + 1;
+			lists[id].focus = y;
+			lists[id].size = k;
+			stack.back() = nid;
+			stack.insert(stack.end() - 1, id);
+		}
+	}
+	// the triangle (next, focus, x) with x on the list p below the top: that list is inserted after the focus, starting at x and ending with a copy of x
+	void merge(Node x, H hfw, H hwn)
+	{
+		ListId id = stack.back(), oid = list(x);
+		Node f = lists[id].focus, n = next(f), xp = prev(x);
+		uint32_t size = lists[id].size + lists[oid].size + 1;
+		V w = vtx(x);
+		Node y = alloc(w, hwn, id);
+		link(xp, y); link(y, n); link(f, x);
+		elements[f].h = hfw;
+		--freec[vtx(f)]; --freec[vtx(n)]; freec[w] -= 2;
+
+		// the elements of the smaller list are relabeled
+		ListId keep = id, drop = oid;
+		if (lists[oid].size <= lists[id].size) {
+			relabel(x, xp, id);
+		} else {
+			relabel(y, f, oid);
+			std::swap(keep, drop);
+		}
+		lists[keep].focus = f;
+		lists[keep].size = size;
+		for (std::size_t i = 0; i < stack.size(); ++i) {
+			if (stack[i] == oid) {
+				stack.erase(stack.begin() + i);
+				break;
+			}
+		}
+		stack.back() = keep;
+		freeids.push_back(drop);
+	}
+	// the list p below the top
+	ListId below(uint32_t p) const
+	{
+		return stack[stack.size() - 1 - p];
+	}
+	// number of lists above l
+	uint32_t depth(ListId l) const
+	{
+		uint32_t p = 0;
+		for (std::size_t i = stack.size(); stack[--i] != l; ) ++p;
+		return p;
+	}
+
+private:
+	// The next focus after p and n became neighbors: the vertex with the fewest free edges among p, the two before it, n and the one after it (p on ties).
+	// Closing the small gaps first keeps the border convex, so the fans of busy vertices rarely run into the list again (splits).
+	Node refocus(Node p, Node n) const
+	{
+		Node best = p, a = p, b = n;
+		int bf = freec[vtx(p)];
+		for (int i = 0; i < 2; ++i) {
+			a = prev(a);
+			if (freec[vtx(a)] < bf) { best = a; bf = freec[vtx(a)]; }
+			if (freec[vtx(b)] < bf) { best = b; bf = freec[vtx(b)]; }
+			b = next(b);
+		}
+		return best;
+	}
+
+	// the last triangle of a list of three
+	void close()
+	{
+		Node n = cur().focus;
+		for (int i = 0; i < 3; ++i) {
+			Node nx = next(n);
+			release(n);
+			n = nx;
+		}
+		freeids.push_back(stack.back());
+		stack.pop_back();
+	}
+
+	ListId new_list()
+	{
+		if (freeids.empty()) {
+			lists.emplace_back();
+			return lists.size() - 1;
+		}
+		ListId id = freeids.back();
+		freeids.pop_back();
+		return id;
+	}
+	// assigns the elements from n to end (inclusive) to list id
+	void relabel(Node n, Node end, ListId id)
+	{
+		for (;; n = next(n)) {
+			elements[n].list = id;
+			if (n == end) break;
+		}
+	}
+	void link(Node a, Node b)
+	{
+		elements[a].next = b;
+		elements[b].prev = a;
+	}
+
+	Node alloc(V v, const H &h, ListId id)
+	{
+		Node n = freelist;
+		if (n == NIL) {
+			n = elements.size();
+			elements.emplace_back();
+		} else {
+			freelist = elements[n].next;
+		}
+		Element &e = elements[n];
+		e.v = v;
+		e.h = h;
+		e.list = id;
+		e.vprev = NIL;
+		e.vnext = vertices[v];
+		if (e.vnext != NIL) elements[e.vnext].vprev = n;
+		vertices[v] = n;
+		return n;
+	}
+	void release(Node n)
+	{
+		Element &e = elements[n];
+		if (e.vprev == NIL) vertices[e.v] = e.vnext;
+		else elements[e.vprev].vnext = e.vnext;
+		if (e.vnext != NIL) elements[e.vnext].vprev = e.vprev;
+		e.next = freelist;
+		freelist = n;
+	}
+};
+
+template <typename V, typename H>
+const uint32_t ActiveLists<V, H>::NIL;
+
+}
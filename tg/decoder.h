@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2017, Max von Buelow
+ * TU Darmstadt - Graphics, Capture and Massively Parallel Computing
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+#pragma once
+
+#include <vector>
+#include <cstdlib>
+#include <stdexcept>
+
+#include "base.h"
+#include "cbm/base.h"
+
+namespace tg {
+
+template <typename M, typename R, typename A, typename V = int, typename F = int>
+void decode(M &mesh, R &rd, A &ac)
+{
+	typedef typename M::Edge Edge;
+	typedef ActiveLists<V, Edge> Lists;
+	typedef typename Lists::Node Node;
+	const V NIL = std::numeric_limits<V>::max();
+
+	Lists al;
+	std::vector<V> idx; // output index per vertex; dummy vertices keep NIL, the others get theirs with their first face
+	std::vector<bool> dummy;
+	V vertexIdx = 0;
+	const Edge none; // the side of a dummy triangle
+	idx.reserve(mesh.num_vtx());
+	dummy.reserve(mesh.num_vtx());
+	al.reserve(mesh.num_vtx());
+
+	auto vertex = [&](int degree, bool d) {
+		V v = idx.size();
+		idx.push_back(NIL);
+		dummy.push_back(d);
+		al.add_vertex(v, degree);
+		return v;
+	};
+	// the triangle (a, b, c); its edges, or none for a dummy triangle
+	auto triangle = [&](V a, V b, V c, Edge *e) {
+		if (dummy[a] || dummy[b] || dummy[c]) {
+			e[0] = e[1] = e[2] = none;
+			return;
+		}
+		F f = mesh.add_face(3);
+		e[0] = mesh.edge(f); e[1] = mesh.next(e[0]); e[2] = mesh.next(e[1]);
+		V v[3] = { a, b, c };
+		for (int i = 0; i < 3; ++i) {
+			bool first = idx[v[i]] == NIL;
+			if (first) idx[v[i]] = vertexIdx++;
+			mesh.set_org(e[i], idx[v[i]]);
+			if (first) ac.vtx(f, i);
+		}
+		ac.face(f, 0);
+	};
+	auto merge = [&](const Edge &a, const Edge &b) {
+		if (!(a == none) && !(b == none)) mesh.merge(a, b);
+	};
+	auto valence = [&]() {
+		int d = rd.valence();
+		if (d < 3) throw std::runtime_error("Invalid valence");
+		return d;
+	};
+
+	while (rd.iop() != cbm::EOM) {
+		V a = vertex(valence(), false), b = vertex(valence(), false), c = vertex(valence(), false);
+		Edge e[3];
+		triangle(a, b, c, e);
+		al.start(a, e[0], b, e[1], c, e[2]);
+
+		while (!al.empty()) {
+			Node f = al.focus(), n = al.next(f), p = al.prev(f), m = al.next(n), x;
+			V vf = al.vtx(f), vn = al.vtx(n), w;
+			uint32_t size = al.cur().size;
+			OP op;
+			int off = 0;
+			if (al.freec[vf] == 0) op = BWD;
+			else if (al.freec[vn] == 0) op = FWD;
+			else op = rd.tgop();
+
+			switch (op) {
+			case ADD:
+				w = vertex(valence(), false);
+				break;
+			case DUMMY:
+				w = vertex(rd.dummy(), true);
+				break;
+			case FWD:
+				w = al.vtx(m);
+				break;
+			case BWD:
+				w = al.vtx(p);
+				break;
+			case SPLIT:
+				off = rd.elem();
+				if (off == 0 || std::abs(off) >= size) throw std::runtime_error("Invalid split");
+				x = al.walk(f, off);
+				w = al.vtx(x);
+				break;
+			case MERGE: {
+				off = rd.elem();
+				uint32_t l = rd.part();
+				if (l == 0 || l >= al.stack.size()) throw std::runtime_error("Invalid merge");
+				x = al.walk(al.lists[al.below(l)].focus, off);
+				w = al.vtx(x);
+				break;
+			}
+			default:
+				throw std::runtime_error("Invalid operation");
+			}
+
+			triangle(vn, vf, w, e);
+			merge(al.handle(f), e[0]);
+			switch (op) {
+			case BWD:
+				merge(al.handle(p), e[1]);
+				if (size == 3) merge(al.handle(n), e[2]);
+				al.backward(e[2]);
+				break;
+			case FWD:
+				merge(al.handle(n), e[2]);
+				if (size == 3) merge(al.handle(m), e[1]);
+				al.forward(e[1]);
+				break;
+			case ADD:
+			case DUMMY:
+				al.add(w, e[1], e[2]);
+				break;
+			case SPLIT:
+				al.split(x, off, e[1], e[2]);
+				break;
+			case MERGE:
+				al.merge(x, e[1], e[2]);
+				break;
+			}
+		}
+	}
+}
+
+}
@@ -0,0 +1,247 @@
+/*
+ * Copyright (C) 2017, Max von Buelow
+ * TU Darmstadt - Graphics, Capture and Massively Parallel Computing
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+#pragma once
+
+#include <vector>
+#include <stdint.h>
+
+#include "base.h"
+
+namespace tg {
+
+// The triangles of the mesh as a corner table (half-edge 3 * t + i is local edge i of triangle t), closed by a dummy vertex per border loop with a fan of dummy triangles
+template <typename M, typename V, typename F>
+struct Closed {
+	V nv, nvtx; // real vertices, all vertices
+	F nf; // real triangles
+	std::vector<V> vtx; // origin per half-edge
+	std::vector<uint32_t> twin;
+	std::vector<int> degree;
+
+	// false if the mesh is not an oriented manifold triangle mesh
+	bool build(M &mesh)
+	{
+		typedef typename M::Edge Edge;
+		const uint32_t NIL = std::numeric_limits<uint32_t>::max();
+		nv = mesh.num_vtx();
+		nf = mesh.num_face();
+		vtx.resize(3 * nf);
+		twin.resize(3 * nf, NIL);
+
+		std::vector<uint32_t> bout(nv, NIL), bin(nv, NIL); // border half-edge leaving and entering each vertex
+		for (F f = 0; f < nf; ++f) {
+			if (mesh.num_edges(f) != 3) return false;
+			Edge e = mesh.first(f);
+			for (int i = 0; i < 3; ++i, e = mesh.next(e)) {
+				uint32_t h = 3 * f + mesh.edge(e);
+				V a = mesh.org(e), b = mesh.org(mesh.next(e));
+				vtx[h] = a;
+				if (a == b) return false;
+				if (mesh.border(e)) {
+					if (bout[a] != NIL || bin[b] != NIL) return false;
+					bout[a] = bin[b] = h;
+					continue;
+				}
+				Edge t = mesh.twin(e);
+				if (mesh.face(t) == f || mesh.twin(t) != e || mesh.org(t) != b || mesh.org(mesh.next(t)) != a) return false;
+				twin[h] = 3 * mesh.face(t) + mesh.edge(t);
+			}
+		}
+
+		// dummy triangle (b, a, d) for every border half-edge h from a to b, following the loops
+		nvtx = nv;
+		for (V a = 0; a < nv; ++a) {
+			if (bout[a] == NIL || twin[bout[a]] != NIL) continue;
+			V d = nvtx++;
+			uint32_t first = vtx.size();
+			for (uint32_t h = bout[a]; twin[h] == NIL; ) {
+				uint32_t t = vtx.size();
+				V x = vtx[h], y = vtx[next(h)];
+				vtx.push_back(y); vtx.push_back(x); vtx.push_back(d);
+				twin.push_back(h); twin.push_back(NIL); twin.push_back(NIL);
+				twin[h] = t;
+				// the side (x, d) pairs with the side (d, x) of the previous triangle of the loop
+				if (t != first) {
+					twin[t + 1] = t - 1;
+					twin[t - 1] = t + 1;
+				}
+				if (bout[y] == NIL) return false;
+				h = bout[y];
+			}
+			uint32_t last = vtx.size() - 3;
+			if (last - first < 6) return false;
+			twin[first + 1] = last + 2;
+			twin[last + 2] = first + 1;
+		}
+
+		// every vertex has a single fan
+		degree.assign(nvtx, 0);
+		std::vector<uint32_t> start(nvtx, NIL);
+		for (uint32_t h = 0; h < vtx.size(); ++h) {
+			++degree[vtx[h]];
+			start[vtx[h]] = h;
+		}
+		for (V v = 0; v < nvtx; ++v) {
+			if (start[v] == NIL) continue;
+			int n = 0;
+			uint32_t h = start[v];
+			do {
+				h = twin[prev(h)];
+				if (++n > degree[v]) return false;
+			} while (h != start[v]);
+			if (n != degree[v]) return false;
+		}
+		return true;
+	}
+
+	static uint32_t next(uint32_t h)
+	{
+		return h % 3 == 2 ? h - 2 : h + 1;
+	}
+	static uint32_t prev(uint32_t h)
+	{
+		return h % 3 == 0 ? h + 2 : h - 1;
+	}
+};
+
+// Returns false if the mesh is not an oriented manifold triangle mesh (also for some meshes that are, e.g. with edges between the same two vertices), in which case the writer has seen an incomplete stream.
+// A dry run tells whether the mesh qualifies.
+template <typename M, typename W, typename A, typename V = int, typename F = int>
+bool encode(M &mesh, W &wr, A &ac)
+{
+	typedef ActiveLists<V, uint32_t> Lists;
+	typedef typename Lists::Node Node;
+	typedef Closed<M, V, F> Closed;
+
+	Closed cm;
+	if (!cm.build(mesh)) return false;
+	Lists al(cm.nvtx);
+	for (V v = 0; v < cm.nvtx; ++v) al.freec[v] = cm.degree[v];
+	std::vector<bool> done(cm.vtx.size() / 3, false), visited(cm.nvtx, false), signaled(cm.nv, false);
+
+	// h0 is the half-edge that becomes edge 0 of the decoded face; new vertices are signaled in the order of its corners
+	auto conquer = [&](uint32_t h0) {
+		F t = h0 / 3;
+		done[t] = true;
+		if (t >= cm.nf) return;
+		for (uint32_t h = h0, i = 0; i < 3; ++i, h = Closed::next(h)) {
+			V v = cm.vtx[h];
+			if (signaled[v]) continue;
+			signaled[v] = true;
+			ac.vtx(t, h % 3);
+		}
+		ac.face(t, h0 % 3);
+	};
+	// the twin of h must still be open: the edge is new to the decoder
+	auto open = [&](uint32_t h) {
+		return !done[cm.twin[h] / 3];
+	};
+	// the element of vertex w whose gap in the conquered region contains triangle t, turning around w from its border edge
+	auto find = [&](V w, F t) {
+		Node x = al.vertices[w];
+		if (x == Lists::NIL || al.elements[x].vnext == Lists::NIL) return x;
+		for (; x != Lists::NIL; x = al.elements[x].vnext) {
+			for (uint32_t h = cm.twin[al.handle(x)]; !done[h / 3]; h = cm.twin[Closed::next(h)]) {
+				if (h / 3 == t) return x;
+			}
+		}
+		return x;
+	};
+
+	for (F seed = 0; ; ++seed) {
+		while (seed < cm.nf && done[seed]) ++seed;
+		if (seed == cm.nf) break;
+
+		V a = cm.vtx[3 * seed], b = cm.vtx[3 * seed + 1], c = cm.vtx[3 * seed + 2];
+		if (visited[a] || visited[b] || visited[c]) return false;
+		visited[a] = visited[b] = visited[c] = true;
+		wr.initial(0);
+		wr.valence(cm.degree[a]); wr.valence(cm.degree[b]); wr.valence(cm.degree[c]);
+		al.start(a, 3 * seed, b, 3 * seed + 1, c, 3 * seed + 2);
+		conquer(3 * seed);
+
+		while (!al.empty()) {
+			Node f = al.focus(), n = al.next(f), p = al.prev(f), m = al.next(n);
+			V vf = al.vtx(f), vn = al.vtx(n);
+			uint32_t size = al.cur().size;
+			uint32_t h0 = cm.twin[al.handle(f)], h1 = Closed::next(h0), h2 = Closed::next(h1);
+			F t = h0 / 3;
+			V w = cm.vtx[h2];
+			if (done[t]) return false;
+
+			OP op;
+			Node x = Lists::NIL;
+			bool implicit = true;
+			if (al.freec[vf] == 0) {
+				op = BWD;
+			} else if (al.freec[vn] == 0) {
+				op = FWD;
+			} else if (!visited[w]) {
+				op = w < cm.nv ? ADD : DUMMY;
+			} else {
+				x = find(w, t);
+				if (x == Lists::NIL) return false;
+				op = x == m ? FWD : x == p ? BWD : al.list(x) == al.list(f) ? SPLIT : MERGE;
+				implicit = false;
+			}
+
+			switch (op) {
+			case BWD:
+				if (w != al.vtx(p) || cm.twin[h1] != al.handle(p)) return false;
+				if (size == 3 ? cm.twin[h2] != al.handle(n) : !open(h2)) return false;
+				if (!implicit) wr.backward();
+				conquer(h0);
+				al.backward(h2);
+				break;
+			case FWD:
+				if (w != al.vtx(m) || cm.twin[h2] != al.handle(n)) return false;
+				if (size == 3 ? cm.twin[h1] != al.handle(m) : !open(h1)) return false;
+				if (!implicit) wr.forward();
+				conquer(h0);
+				al.forward(h1);
+				break;
+			case ADD:
+			case DUMMY:
+				if (!open(h1) || !open(h2)) return false;
+				if (op == ADD) wr.addvertex(cm.degree[w]);
+				else wr.adddummy(cm.degree[w]);
+				visited[w] = true;
+				conquer(h0);
+				al.add(w, h1, h2);
+				break;
+			case SPLIT: {
+				if (!open(h1) || !open(h2)) return false;
+				int off = al.offset(f, x);
+				wr.splitlist(off);
+				conquer(h0);
+				al.split(x, off, h1, h2);
+				break;
+			}
+			case MERGE: {
+				if (!open(h1) || !open(h2)) return false;
+				typename Lists::ListId l = al.list(x);
+				uint32_t depth = al.depth(l);
+				if (depth > 0xffff) return false;
+				wr.mergelist(al.offset(al.lists[l].focus, x), depth);
+				conquer(h0);
+				al.merge(x, h1, h2);
+				break;
+			}
+			}
+			for (V v : { vf, vn, w }) {
+				if (al.freec[v] < 0) return false;
+			}
+		}
+	}
+	wr.end();
+	return true;
+}
+
+}
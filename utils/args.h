@@ -220,7 +220,7 @@ public:
 
 private:
 	template <typename C, typename TK, typename TV, typename ...T>
-	TV _map(C &&val, TK &&key, TV &&mapped)
+	TV &&_map(C &&val, TK &&key, TV &&mapped)
 	{
 		if (key == val) return std::move(mapped);
 		else err(E_ENUM);